@@ -2,15 +2,49 @@
 #include <freertos/task.h>
 #include <esp_system.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <driver/ledc.h>
 #include <driver/spi_master.h>
 #include <driver/rtc_io.h>
+#include <soc/soc_memory_layout.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include "display.h"
 
+#define RG_MIN(a, b) ({__typeof__(a) _a = (a); __typeof__(b) _b = (b);_a < _b ? _a : _b; })
+
+// The SD Card driver initializes the shared SPI bus with a 4KB max transfer size
+#define LCD_TRANSFER_LINES (4000 / (SCREEN_WIDTH * 2))
+
+// Unchanged rows between two dirty runs are resent if the gap is smaller than this,
+// it is cheaper than setting up a new window.
+#define LCD_MERGE_GAP 2
+
+#define LCD_SPI_CLOCK SPI_MASTER_FREQ_40M
+
 static spi_device_handle_t spi;
-static DMA_ATTR uint16_t dma_buffer[SCREEN_WIDTH];
+static DMA_ATTR uint16_t dma_buffer[2][SCREEN_WIDTH * LCD_TRANSFER_LINES];
+static spi_transaction_t dma_trans[2];
+static uint32_t row_hash[SCREEN_HEIGHT];
+static uint8_t row_stale[SCREEN_HEIGHT];
+static uint32_t palette_hash;
+static bool row_hash_valid = false;
+
+// Hardware scrolling area, in screen rows
+static int scroll_top = 0;
+static int scroll_height = 0;
+static int scroll_offset = 0;
+static bool scroll_pending = false;
+
+static lcd_stats_t stats;
+
+typedef enum
+{
+    LCD_FORMAT_RGB565_LE,
+    LCD_FORMAT_RGB565_BE,
+    LCD_FORMAT_INDEXED8,
+} lcd_format_t;
 
 static const struct {
     uint8_t cmd;
@@ -67,6 +101,17 @@ static void ili_cmd(spi_device_handle_t spi, const uint8_t cmd)
     };
     esp_err_t ret = spi_device_transmit(spi, &t);
     assert(ret==ESP_OK);
+
+    stats.transactions++;
+    stats.bytes++;
+    switch (cmd)
+    {
+        case 0x2A: stats.windows++; break;  // Column address set, always followed by 0x2B
+        case 0x2B: break;
+        case 0x2C: stats.memory_writes++; break;
+        case 0x37: stats.scrolls++; break;
+        default: stats.other_commands++; break;
+    }
 }
 
 static void ili_data(spi_device_handle_t spi, const void *data, int len)
@@ -78,6 +123,9 @@ static void ili_data(spi_device_handle_t spi, const void *data, int len)
     };
     esp_err_t ret = spi_device_transmit(spi, &t);
     assert(ret==ESP_OK);
+
+    stats.transactions++;
+    stats.bytes += len;
 }
 
 static void ili_spi_pre_transfer_callback(spi_transaction_t *t)
@@ -85,13 +133,8 @@ static void ili_spi_pre_transfer_callback(spi_transaction_t *t)
     gpio_set_level(LCD_PIN_NUM_DC, (int)t->user & 1);
 }
 
-void ili9341_writeLE(const uint16_t *buffer)
+static void ili_set_window(int left, int top, int width, int height)
 {
-    const int left = 0;
-    const int top = SCREEN_OFFSET_TOP;
-    const int width = SCREEN_WIDTH;
-    const int height = SCREEN_HEIGHT;
-
     uint8_t tx_data[4];
 
     tx_data[0] = (left) >> 8;              //Start Col High
@@ -109,20 +152,260 @@ void ili9341_writeLE(const uint16_t *buffer)
     ili_data(spi, tx_data, 4);
 
     ili_cmd(spi, 0x2C);
+}
+
+static inline uint32_t ili_hash(const void *buffer, size_t length)
+{
+    const uint32_t *data = (const uint32_t *)buffer;
+    uint32_t hash = 0x811C9DC5;
+
+    for (int i = 0; i < length / 4; i++)
+    {
+        hash = (hash ^ data[i]) * 0x01000193;
+    }
+
+    return hash;
+}
+
+// Bands are prepared in one DMA buffer while the other one is being sent, so a framebuffer
+// in PSRAM costs little more than one in internal RAM.
+static void ili_write_lines(const void *buffer, int top, int height, int panel_top, lcd_format_t format, const uint16_t *palette)
+{
+    const int width = SCREEN_WIDTH;
+    const bool zero_copy = format == LCD_FORMAT_RGB565_BE && esp_ptr_dma_capable(buffer);
+    spi_transaction_t *t;
+    int pending = 0;
+    int band = 0;
+
+    ili_set_window(0, panel_top, width, height);
 
-    for (int y = 0; y < height; y++)
+    for (int y = top; y < top + height; y += LCD_TRANSFER_LINES)
     {
-        for (int i = 0; i < width; ++i)
+        int lines = top + height - y < LCD_TRANSFER_LINES ? top + height - y : LCD_TRANSFER_LINES;
+        const uint16_t *data = (const uint16_t *)buffer + y * width;
+
+        // Wait for the oldest transfer, it owns the band we're about to reuse
+        if (pending == 2)
+        {
+            esp_err_t ret = spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+            assert(ret==ESP_OK);
+            pending--;
+        }
+
+        if (format == LCD_FORMAT_INDEXED8)
+        {
+            const uint8_t *indexes = (const uint8_t *)buffer + y * width;
+            for (int i = 0; i < lines * width; ++i)
+            {
+                dma_buffer[band][i] = palette[indexes[i]];
+            }
+            data = dma_buffer[band];
+        }
+        else if (format == LCD_FORMAT_RGB565_LE)
+        {
+            for (int i = 0; i < lines * width; ++i)
+            {
+                uint16_t pixel = data[i];
+                dma_buffer[band][i] = pixel << 8 | pixel >> 8;
+            }
+            data = dma_buffer[band];
+        }
+        else if (!zero_copy)
+        {
+            data = memcpy(dma_buffer[band], data, lines * width * 2);
+        }
+
+        dma_trans[band] = (spi_transaction_t){
+            .length = lines * width * 2 * 8,  // In bits
+            .tx_buffer = data,
+            .user = (void*)1,   // DC Line
+        };
+        esp_err_t ret = spi_device_queue_trans(spi, &dma_trans[band], portMAX_DELAY);
+        assert(ret==ESP_OK);
+        pending++;
+        band ^= 1;
+
+        stats.transactions++;
+        stats.bytes += lines * width * 2;
+        stats.rows += lines;
+    }
+
+    // ili_cmd/ili_data expect an empty queue
+    while (pending--)
+    {
+        esp_err_t ret = spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+        assert(ret==ESP_OK);
+    }
+}
+
+// Rows inside the scrolling area are rotated by the scroll offset in the panel's memory,
+// a run that wraps around the end of the area must be split in two windows.
+static void ili_write_run(const void *buffer, int top, int height, lcd_format_t format, const uint16_t *palette)
+{
+    while (height > 0)
+    {
+        int count = height;
+        int panel_top = SCREEN_OFFSET_TOP + top;
+
+        if (scroll_height > 0 && top < scroll_top)
+        {
+            count = RG_MIN(height, scroll_top - top);
+        }
+        else if (scroll_height > 0 && top < scroll_top + scroll_height)
         {
-            uint16_t pixel = buffer[y * width + i];
-            dma_buffer[i] = pixel << 8 | pixel >> 8;
+            int row = (top - scroll_top + scroll_offset) % scroll_height;
+            count = RG_MIN(height, scroll_height - row);
+            count = RG_MIN(count, scroll_top + scroll_height - top);
+            panel_top = SCREEN_OFFSET_TOP + scroll_top + row;
         }
-        ili_data(spi, dma_buffer, width * 2);
+
+        ili_write_lines(buffer, top, count, panel_top, format, palette);
+        top += count;
+        height -= count;
     }
 }
 
+// Only the runs of rows that changed since the last frame are sent to the panel
+static void ili_write_frame(const void *buffer, lcd_format_t format, const uint16_t *palette)
+{
+    const size_t stride = SCREEN_WIDTH * (format == LCD_FORMAT_INDEXED8 ? 1 : 2);
+    const int64_t start_time = esp_timer_get_time();
+    const uint32_t start_bytes = stats.bytes;
+    uint8_t dirty[SCREEN_HEIGHT];
+
+    // A different palette changes the meaning of every row
+    if (palette)
+    {
+        uint32_t hash = ili_hash(palette, 256 * 2);
+        if (hash != palette_hash)
+            row_hash_valid = false;
+        palette_hash = hash;
+    }
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+    {
+        uint32_t hash = ili_hash((const uint8_t *)buffer + y * stride, stride);
+        dirty[y] = !row_hash_valid || row_stale[y] || hash != row_hash[y];
+        row_hash[y] = hash;
+        row_stale[y] = 0;
+    }
+
+    row_hash_valid = true;
+
+    if (scroll_pending)
+    {
+        uint16_t start = SCREEN_OFFSET_TOP + scroll_top + scroll_offset;
+        ili_cmd(spi, 0x37);
+        ili_data(spi, (uint8_t[]){start >> 8, start & 0xff}, 2);
+        scroll_pending = false;
+    }
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+    {
+        if (!dirty[y])
+            continue;
+
+        int top = y, bottom = y;
+
+        for (y++; y < SCREEN_HEIGHT && y <= bottom + LCD_MERGE_GAP + 1; y++)
+        {
+            if (dirty[y])
+                bottom = y;
+        }
+
+        ili_write_run(buffer, top, bottom - top + 1, format, palette);
+        y = bottom;
+    }
+
+    stats.frames++;
+    stats.busy_us += esp_timer_get_time() - start_time;
+
+    ESP_LOGD(__func__, "frame %u: %u bytes, %lld us", stats.frames, stats.bytes - start_bytes,
+        esp_timer_get_time() - start_time);
+}
+
+void ili9341_writeLE(const uint16_t *buffer)
+{
+    ili_write_frame(buffer, LCD_FORMAT_RGB565_LE, NULL);
+}
+
+// The buffer is already in the panel's byte order, if it lives in DMA-capable memory
+// we can hand it to the SPI driver directly without touching the pixels.
+void ili9341_writeBE(const uint16_t *buffer)
+{
+    ili_write_frame(buffer, LCD_FORMAT_RGB565_BE, NULL);
+}
+
+// Each byte of the buffer is an index in a 256 colors palette (in the panel's byte order)
+void ili9341_writeIndexed(const uint8_t *buffer, const uint16_t *palette)
+{
+    ili_write_frame(buffer, LCD_FORMAT_INDEXED8, palette);
+}
+
+// Tells the driver that the framebuffer rows [top, top + height) moved up by `lines` (down if
+// negative). The panel does the same in hardware on the next write, so only the rows that
+// were exposed have to be sent. Returns false if the panel can't scroll that way.
+bool ili9341_scroll(int top, int height, int lines)
+{
+    if (!LCD_HW_VSCROLL || height <= 0 || abs(lines) >= height)
+        return false;
+
+    if (top != scroll_top || height != scroll_height)
+    {
+        // Vertical Scrolling Definition: top fixed area, scrolling area, bottom fixed area
+        uint16_t tfa = SCREEN_OFFSET_TOP + top;
+        uint16_t bfa = LCD_GRAM_HEIGHT - tfa - height;
+        ili_cmd(spi, 0x33);
+        ili_data(spi, (uint8_t[]){tfa >> 8, tfa & 0xff, height >> 8, height & 0xff, bfa >> 8, bfa & 0xff}, 6);
+
+        // The rows were laid out for the previous area, resend everything
+        scroll_top = top;
+        scroll_height = height;
+        scroll_offset = 0;
+        scroll_pending = true;
+        row_hash_valid = false;
+        return true;
+    }
+
+    scroll_offset = (scroll_offset + lines + height) % height;
+    scroll_pending = true;
+
+    if (lines > 0)
+    {
+        memmove(&row_hash[top], &row_hash[top + lines], (height - lines) * sizeof(row_hash[0]));
+        memset(&row_stale[top + height - lines], 1, lines);
+    }
+    else if (lines < 0)
+    {
+        memmove(&row_hash[top - lines], &row_hash[top], (height + lines) * sizeof(row_hash[0]));
+        memset(&row_stale[top], 1, -lines);
+    }
+
+    return true;
+}
+
+// Counts everything sent to the panel since boot (or the last reset). The wire time is
+// what the bytes alone cost at the bus clock, it excludes the per-transaction overhead.
+void ili9341_get_stats(lcd_stats_t *out, bool reset)
+{
+    *out = stats;
+    out->wire_us = (uint64_t)stats.bytes * 8 * 1000000 / LCD_SPI_CLOCK;
+
+    if (reset)
+        memset(&stats, 0, sizeof(stats));
+}
+
 void ili9341_deinit()
 {
+    // The next firmware may not reset the panel, leave it unscrolled in normal display mode
+    if (scroll_height > 0)
+    {
+        ili_cmd(spi, 0x37);
+        ili_data(spi, (uint8_t[]){0, 0}, 2);
+        ili_cmd(spi, 0x13);
+        scroll_top = scroll_height = scroll_offset = 0;
+    }
+
     spi_bus_remove_device(spi);
     gpio_reset_pin(LCD_PIN_NUM_DC);
     gpio_reset_pin(LCD_PIN_NUM_BCKL);
@@ -169,7 +452,7 @@ void ili9341_init()
     };
 
     spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = SPI_MASTER_FREQ_40M,
+        .clock_speed_hz = LCD_SPI_CLOCK,
         .mode = 0,
         .spics_io_num = LCD_PIN_NUM_CS,
         .queue_size = 4,
@@ -189,8 +472,8 @@ void ili9341_init()
         ili_cmd(spi, ili_init_cmds[cmd].cmd);
         if (datalen > 0)
         {
-            memcpy(dma_buffer, ili_init_cmds[cmd].data, datalen);
-            ili_data(spi, dma_buffer, datalen);
+            memcpy(dma_buffer[0], ili_init_cmds[cmd].data, datalen);
+            ili_data(spi, dma_buffer[0], datalen);
         }
         if (ili_init_cmds[cmd].databytes & 0x80)
             vTaskDelay(pdMS_TO_TICKS(100));
@@ -202,9 +485,9 @@ void ili9341_init()
     ili_cmd(spi, 0x2B);
     ili_data(spi, (uint8_t[]){0, 0, 0xFF, 0xFF}, 4);
     ili_cmd(spi, 0x2C);
-    memset(dma_buffer, 0, SCREEN_WIDTH * 2);
+    memset(dma_buffer[0], 0, SCREEN_WIDTH * 2);
     for (int p = 0; p < 320 * 240; p += SCREEN_WIDTH)
-        ili_data(spi, dma_buffer, SCREEN_WIDTH * 2);
+        ili_data(spi, dma_buffer[0], SCREEN_WIDTH * 2);
 
     ESP_LOGI(__func__, "LCD Initialized.");
 }
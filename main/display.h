@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #ifdef TARGET_MRGC_G32
 #define LCD_PIN_NUM_MISO GPIO_NUM_NC
 #define LCD_PIN_NUM_MOSI GPIO_NUM_23
@@ -11,6 +14,14 @@
 #define SCREEN_OFFSET_TOP 28
 #define SCREEN_WIDTH 240
 #define SCREEN_HEIGHT 224
+
+// The vertical scrolling commands move along the panel's native rows, this is
+// only vertical on screen when the panel isn't rotated. Untested: it hasn't been
+// checked on an MRGC-G32 or against an emulator. It relies on the scroll area
+// (rows SCREEN_OFFSET_TOP+top..) mapping like the ILI9341's VSCRDEF/VSCRSADD and
+// on DisplayRow drawing a shifted row exactly as it was, row_hash is moved with
+// the rows. Set it to 0 to go back to redrawing whole pages.
+#define LCD_HW_VSCROLL 1
 #else
 #define LCD_PIN_NUM_MISO GPIO_NUM_19
 #define LCD_PIN_NUM_MOSI GPIO_NUM_23
@@ -22,9 +33,30 @@
 #define SCREEN_OFFSET_TOP 0
 #define SCREEN_WIDTH 320
 #define SCREEN_HEIGHT 240
+
+// Compiled out, the scroll axis is horizontal on screen (MADCTL MV)
+#define LCD_HW_VSCROLL 0
 #endif
 
+#define LCD_GRAM_HEIGHT 320
+
+typedef struct {
+    uint32_t frames;
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t rows;           // Framebuffer rows sent
+    uint32_t windows;        // Column/page address sets
+    uint32_t memory_writes;
+    uint32_t scrolls;
+    uint32_t other_commands;
+    uint64_t busy_us;        // Time spent in the write functions
+    uint64_t wire_us;        // Time the bytes take on the bus
+} lcd_stats_t;
+
 void ili9341_init(void);
 void ili9341_deinit(void);
 void ili9341_writeLE(const uint16_t *buffer);
 void ili9341_writeBE(const uint16_t *buffer);
+void ili9341_writeIndexed(const uint8_t *buffer, const uint16_t *palette);
+bool ili9341_scroll(int top, int height, int lines);
+void ili9341_get_stats(lcd_stats_t *out, bool reset);
@@ -1,16 +1,95 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <driver/gpio.h>
 #include <driver/adc.h>
 #include <driver/i2c.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+#if defined(ESP_IDF_VERSION_MAJOR) && ESP_IDF_VERSION_MAJOR >= 4
+#include <esp32/rom/ets_sys.h>
+#else
+#include <rom/ets_sys.h>
+#endif
 
 #include "input.h"
 
+#define RG_MIN(a, b) ({__typeof__(a) _a = (a); __typeof__(b) _b = (b);_a < _b ? _a : _b; })
+#define RG_MAX(a, b) ({__typeof__(a) _a = (a); __typeof__(b) _b = (b);_a > _b ? _a : _b; })
+
 #ifdef TARGET_MRGC_G32
 #define TRY(x) if ((err = (x)) != ESP_OK) { goto fail; }
 
+#define I2C_PIN_NUM_SDA GPIO_NUM_21
+#define I2C_PIN_NUM_SCL GPIO_NUM_22
+
+// A read of the gamepad takes well under a millisecond, a transaction that isn't done after
+// a couple of ticks is stuck. Failed reads are retried less and less often (up to every
+// I2C_MAX_BACKOFF polls) and after I2C_RECOVER_AFTER failures in a row the bus is reset.
+// The buttons read last are held until there was no good read for I2C_RELEASE_AFTER.
+// A read still blocks the input task for up to I2C_TIMEOUT: the transactions aren't queued
+// and polled, and the backoff and recovery haven't been tested against a misbehaving slave.
+#define I2C_TIMEOUT pdMS_TO_TICKS(20)
+#define I2C_MAX_BACKOFF 32
+#define I2C_RECOVER_AFTER 3
+#define I2C_RELEASE_AFTER pdMS_TO_TICKS(250)
+
+static bool rg_i2c_init(void)
+{
+    const i2c_config_t i2c_config = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_PIN_NUM_SDA,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_io_num = I2C_PIN_NUM_SCL,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = 200000,
+    };
+    esp_err_t err = ESP_FAIL;
+
+    TRY(i2c_param_config(I2C_NUM_0, &i2c_config));
+    TRY(i2c_driver_install(I2C_NUM_0, I2C_MODE_MASTER, 0, 0, 0));
+    ESP_LOGI(__func__, "I2C driver ready (SDA:%d SCL:%d).\n", i2c_config.sda_io_num, i2c_config.scl_io_num);
+    return true;
+
+fail:
+    ESP_LOGE(__func__, "I2C driver init failed. err=0x%x\n", err);
+    return false;
+}
+
+// A slave reset in the middle of a read can hold SDA low forever. Clocking SCL until it lets
+// go and sending a STOP frees the bus, then the driver is reinstalled from a clean state.
+static void rg_i2c_recover(void)
+{
+    ESP_LOGW(__func__, "Recovering I2C bus...");
+
+    i2c_driver_delete(I2C_NUM_0);
+
+    gpio_set_direction(I2C_PIN_NUM_SDA, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_direction(I2C_PIN_NUM_SCL, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(I2C_PIN_NUM_SDA, 1);
+
+    for (int i = 0; i < 9 && !gpio_get_level(I2C_PIN_NUM_SDA); i++)
+    {
+        gpio_set_level(I2C_PIN_NUM_SCL, 0);
+        ets_delay_us(5);
+        gpio_set_level(I2C_PIN_NUM_SCL, 1);
+        ets_delay_us(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_level(I2C_PIN_NUM_SDA, 0);
+    ets_delay_us(5);
+    gpio_set_level(I2C_PIN_NUM_SCL, 1);
+    ets_delay_us(5);
+    gpio_set_level(I2C_PIN_NUM_SDA, 1);
+    ets_delay_us(5);
+
+    rg_i2c_init();
+}
+
 static bool rg_i2c_read(uint8_t addr, int reg, void *read_data, size_t read_len)
 {
     esp_err_t err = ESP_FAIL;
@@ -26,12 +105,42 @@ static bool rg_i2c_read(uint8_t addr, int reg, void *read_data, size_t read_len)
     TRY(i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_READ, true));
     TRY(i2c_master_read(cmd, read_data, read_len, I2C_MASTER_LAST_NACK));
     TRY(i2c_master_stop(cmd));
-    TRY(i2c_master_cmd_begin(I2C_NUM_0, cmd, pdMS_TO_TICKS(500)));
+    TRY(i2c_master_cmd_begin(I2C_NUM_0, cmd, I2C_TIMEOUT));
     i2c_cmd_link_delete(cmd);
     return true;
 
 fail:
-    ESP_LOGE(__func__, "Read from 0x%02x failed. reg=%d, err=0x%x\n", addr, reg, err);
+    i2c_cmd_link_delete(cmd);
+    return false;
+}
+
+// Reads the gamepad, with the backoff and recovery described above
+static bool rg_gamepad_read(uint8_t *data, size_t len)
+{
+    static int failures = 0;
+    static int skip = 0;
+
+    if (skip > 0)
+    {
+        skip--;
+        return false;
+    }
+
+    if (rg_i2c_read(0x20, -1, data, len))
+    {
+        if (failures > 0)
+            ESP_LOGI(__func__, "Gamepad is back after %d failed reads.", failures);
+        failures = 0;
+        return true;
+    }
+
+    if (failures++ == 0)
+        ESP_LOGE(__func__, "Gamepad read failed.");
+
+    if (failures % I2C_RECOVER_AFTER == 0)
+        rg_i2c_recover();
+
+    skip = RG_MIN(1 << RG_MIN(failures, 5), I2C_MAX_BACKOFF);
     return false;
 }
 #else
@@ -45,7 +154,28 @@ fail:
 #define ODROID_GAMEPAD_IO_VOLUME GPIO_NUM_0
 #endif
 
+// Presses and releases are queued as they're debounced, so that none is lost between two
+// calls and waiting for one doesn't involve polling. Events are dropped when it's full.
+#define INPUT_QUEUE_LENGTH 16
+
+// The buttons are sampled every INPUT_FAST_PERIOD while something is happening, and
+// every INPUT_SLOW_PERIOD once nothing changed for INPUT_IDLE_DELAY. An edge on a GPIO
+// button ends the idle wait early, the following samples keep the fixed fast period so
+// that the debouncing still compares samples INPUT_FAST_PERIOD apart.
+#define INPUT_FAST_PERIOD pdMS_TO_TICKS(10)
+#define INPUT_SLOW_PERIOD pdMS_TO_TICKS(40)
+#define INPUT_IDLE_DELAY  pdMS_TO_TICKS(500)
+
+// Holding a direction repeats it after INPUT_REPEAT_DELAY, every INPUT_REPEAT_INTERVAL at
+// first then a quarter faster each time down to INPUT_REPEAT_MIN_INTERVAL.
+#define INPUT_REPEAT_MASK ((1 << ODROID_INPUT_UP) | (1 << ODROID_INPUT_DOWN) | (1 << ODROID_INPUT_LEFT) | (1 << ODROID_INPUT_RIGHT))
+#define INPUT_REPEAT_DELAY pdMS_TO_TICKS(400)
+#define INPUT_REPEAT_INTERVAL pdMS_TO_TICKS(120)
+#define INPUT_REPEAT_MIN_INTERVAL pdMS_TO_TICKS(30)
+
 static uint32_t gamepad_state = 0;
+static QueueHandle_t input_queue;
+static TaskHandle_t input_task_handle;
 
 
 uint32_t input_read_raw(void)
@@ -53,22 +183,34 @@ uint32_t input_read_raw(void)
     uint32_t state = 0;
 
 #ifdef TARGET_MRGC_G32
+    static uint32_t last_state = 0;
+    static TickType_t last_read = 0;
     uint8_t data[5];
-    if (rg_i2c_read(0x20, -1, &data, 5))
+
+    // Hold the last state through a short glitch, a longer outage releases everything. Polls
+    // skipped by the backoff don't count, only the time since the last good read does.
+    if (!rg_gamepad_read(data, 5))
     {
-        int buttons = ~((data[2] << 8) | data[1]);
-
-        if (buttons & (1 << 2)) state |= (1 << ODROID_INPUT_UP);
-        if (buttons & (1 << 3)) state |= (1 << ODROID_INPUT_DOWN);
-        if (buttons & (1 << 4)) state |= (1 << ODROID_INPUT_LEFT);
-        if (buttons & (1 << 5)) state |= (1 << ODROID_INPUT_RIGHT);
-        if (buttons & (1 << 8)) state |= (1 << ODROID_INPUT_MENU);
-        // if (buttons & (1 << 0)) state |= (1 << ODROID_INPUT_OPTION);
-        if (buttons & (1 << 1)) state |= (1 << ODROID_INPUT_SELECT);
-        if (buttons & (1 << 0)) state |= (1 << ODROID_INPUT_START);
-        if (buttons & (1 << 6)) state |= (1 << ODROID_INPUT_A);
-        if (buttons & (1 << 7)) state |= (1 << ODROID_INPUT_B);
+        if (xTaskGetTickCount() - last_read > I2C_RELEASE_AFTER)
+            last_state = 0;
+        return last_state;
     }
+
+    int buttons = ~((data[2] << 8) | data[1]);
+
+    if (buttons & (1 << 2)) state |= (1 << ODROID_INPUT_UP);
+    if (buttons & (1 << 3)) state |= (1 << ODROID_INPUT_DOWN);
+    if (buttons & (1 << 4)) state |= (1 << ODROID_INPUT_LEFT);
+    if (buttons & (1 << 5)) state |= (1 << ODROID_INPUT_RIGHT);
+    if (buttons & (1 << 8)) state |= (1 << ODROID_INPUT_MENU);
+    // if (buttons & (1 << 0)) state |= (1 << ODROID_INPUT_OPTION);
+    if (buttons & (1 << 1)) state |= (1 << ODROID_INPUT_SELECT);
+    if (buttons & (1 << 0)) state |= (1 << ODROID_INPUT_START);
+    if (buttons & (1 << 6)) state |= (1 << ODROID_INPUT_A);
+    if (buttons & (1 << 7)) state |= (1 << ODROID_INPUT_B);
+
+    last_state = state;
+    last_read = xTaskGetTickCount();
 #else
     int joyX = adc1_get_raw(ODROID_GAMEPAD_IO_X);
     int joyY = adc1_get_raw(ODROID_GAMEPAD_IO_Y);
@@ -94,35 +236,77 @@ uint32_t input_read_raw(void)
     return state;
 }
 
-int input_wait_for_button_press(int ticks)
+// Waits up to `ticks` (forever if <= 0) for the next press or release
+bool input_wait_for_event(input_event_t *event, int ticks)
 {
-    uint32_t previousState = gamepad_state;
-    uint32_t timeout = xTaskGetTickCount() + ticks;
+    return xQueueReceive(input_queue, event, ticks > 0 ? ticks : portMAX_DELAY) == pdTRUE;
+}
+
+// Waits for a press. If it's a repeat and more repeats of the same button are already
+// queued (the caller fell behind), they're all consumed and counted in `count`.
+int input_wait_for_button(int ticks, int *count)
+{
+    TickType_t start = xTaskGetTickCount();
+    input_event_t event, next;
 
     while (true)
     {
-        uint32_t state = gamepad_state;
+        TickType_t elapsed = xTaskGetTickCount() - start;  // Safe across tick wraparound
 
-        for (int i = 0; i < ODROID_INPUT_MAX; i++)
-        {
-            if (!(previousState & (1 << i)) && (state & (1 << i))) {
-                return i;
-            }
-        }
+        if (ticks > 0 && elapsed >= ticks)
+            break;
 
-        if (ticks > 0 && timeout < xTaskGetTickCount()) {
+        if (!input_wait_for_event(&event, ticks > 0 ? ticks - elapsed : 0))
             break;
+
+        if (!event.pressed)
+            continue;
+
+        int repeats = 1;
+
+        while (count && event.repeat && xQueuePeek(input_queue, &next, 0) == pdTRUE
+               && next.repeat && next.button == event.button)
+        {
+            xQueueReceive(input_queue, &next, 0);
+            repeats++;
         }
 
-        previousState = state;
-        vTaskDelay(pdMS_TO_TICKS(10));
+        if (count)
+            *count = repeats;
+
+        return event.button;
     }
 
     return -1;
 }
 
+int input_wait_for_button_press(int ticks)
+{
+    return input_wait_for_button(ticks, NULL);
+}
+
+// Drops the queued events, before a prompt that presses made earlier mustn't answer
+void input_flush(void)
+{
+    xQueueReset(input_queue);
+}
+
+#ifndef TARGET_MRGC_G32
+static void IRAM_ATTR input_gpio_isr(void *arg)
+{
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(input_task_handle, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken)
+        portYIELD_FROM_ISR();
+}
+#endif
+
 static void input_task(void *arg)
 {
+    TickType_t lastActivity = xTaskGetTickCount();
+    TickType_t lastWake = xTaskGetTickCount();
+    TickType_t repeatAt[ODROID_INPUT_MAX];
+    TickType_t repeatInterval[ODROID_INPUT_MAX];
     uint8_t debounce[ODROID_INPUT_MAX];
 
     // Initialize state
@@ -136,11 +320,16 @@ static void input_task(void *arg)
         // Read hardware
         uint32_t state = input_read_raw();
 
+        // Anything held or bouncing keeps the fast rate
+        if (state != 0 || state != gamepad_state)
+            lastActivity = xTaskGetTickCount();
+
         // Debounce
         for (int i = 0; i < ODROID_INPUT_MAX; ++i)
         {
             debounce[i] <<= 1;
             debounce[i] |= (state >> i) & 1;
+            uint32_t previous = gamepad_state;
             switch (debounce[i] & 0x03)
             {
                 case 0x00:
@@ -155,9 +344,48 @@ static void input_task(void *arg)
                     // ignore
                     break;
             }
+
+            if ((previous ^ gamepad_state) & (1 << i))
+            {
+                input_event_t event = {
+                    .button = i,
+                    .pressed = (gamepad_state >> i) & 1,
+                    .time = esp_timer_get_time(),
+                };
+                xQueueSend(input_queue, &event, 0);
+
+                repeatAt[i] = xTaskGetTickCount() + INPUT_REPEAT_DELAY;
+                repeatInterval[i] = INPUT_REPEAT_INTERVAL;
+            }
+            else if ((gamepad_state & INPUT_REPEAT_MASK & (1 << i))
+                     && (int32_t)(xTaskGetTickCount() - repeatAt[i]) >= 0)
+            {
+                input_event_t event = {
+                    .button = i,
+                    .pressed = true,
+                    .repeat = true,
+                    .time = esp_timer_get_time(),
+                };
+                xQueueSend(input_queue, &event, 0);
+
+                repeatAt[i] += repeatInterval[i];
+                repeatInterval[i] = RG_MAX(repeatInterval[i] * 3 / 4, INPUT_REPEAT_MIN_INTERVAL);
+            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        bool idle = xTaskGetTickCount() - lastActivity > INPUT_IDLE_DELAY;
+
+        if (idle)
+        {
+            // Edges only matter here, while active they don't change when the next sample is
+            if (ulTaskNotifyTake(pdTRUE, INPUT_SLOW_PERIOD))
+                lastActivity = xTaskGetTickCount();
+            lastWake = xTaskGetTickCount();
+        }
+        else
+        {
+            vTaskDelayUntil(&lastWake, INPUT_FAST_PERIOD);
+        }
     }
 
     vTaskDelete(NULL);
@@ -166,20 +394,7 @@ static void input_task(void *arg)
 void input_init(void)
 {
 #ifdef TARGET_MRGC_G32
-    const i2c_config_t i2c_config = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = GPIO_NUM_21,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_io_num = GPIO_NUM_22,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 200000,
-    };
-    esp_err_t err = ESP_FAIL;
-
-    TRY(i2c_param_config(I2C_NUM_0, &i2c_config));
-    TRY(i2c_driver_install(I2C_NUM_0, I2C_MODE_MASTER, 0, 0, 0));
-    ESP_LOGI(__func__, "I2C driver ready (SDA:%d SCL:%d).\n", i2c_config.sda_io_num, i2c_config.scl_io_num);
-    fail:
+    rg_i2c_init();
 #else
     gpio_set_direction(ODROID_GAMEPAD_IO_SELECT, GPIO_MODE_INPUT);
     gpio_set_pull_mode(ODROID_GAMEPAD_IO_SELECT, GPIO_PULLUP_ONLY);
@@ -202,8 +417,24 @@ void input_init(void)
     gpio_set_direction(ODROID_GAMEPAD_IO_VOLUME, GPIO_MODE_INPUT);
 #endif
 
+    input_queue = xQueueCreate(INPUT_QUEUE_LENGTH, sizeof(input_event_t));
+
     // Start background polling
-    xTaskCreatePinnedToCore(&input_task, "input_task", 1024 * 2, NULL, 5, NULL, 1);
+    xTaskCreatePinnedToCore(&input_task, "input_task", 1024 * 2, NULL, 5, &input_task_handle, 1);
+
+#ifndef TARGET_MRGC_G32
+    // Wake the task up on any edge of the digital buttons, it then debounces at the fast rate.
+    // Not START: GPIO 39 sees spurious edges every time the ADC powers up (ESP32 errata)
+    // and the joystick is read on every sample, it's picked up by the idle polling instead.
+    const gpio_num_t buttons[] = {ODROID_GAMEPAD_IO_SELECT, ODROID_GAMEPAD_IO_A, ODROID_GAMEPAD_IO_B,
+                                  ODROID_GAMEPAD_IO_MENU, ODROID_GAMEPAD_IO_VOLUME};
+    gpio_install_isr_service(0);
+    for (int i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++)
+    {
+        gpio_set_intr_type(buttons[i], GPIO_INTR_ANYEDGE);
+        gpio_isr_handler_add(buttons[i], &input_gpio_isr, NULL);
+    }
+#endif
 
     ESP_LOGI(__func__, "done.");
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 enum
 {
@@ -18,6 +19,17 @@ enum
 	ODROID_INPUT_MAX
 };
 
+typedef struct
+{
+    uint8_t button;
+    bool pressed;     // false when released
+    bool repeat;      // Generated while the button is held
+    int64_t time;     // esp_timer_get_time() when the change was debounced
+} input_event_t;
+
 void input_init(void);
 uint32_t input_read_raw();
+bool input_wait_for_event(input_event_t *event, int ticks);
+int input_wait_for_button(int ticks, int *count);
 int input_wait_for_button_press(int ticks);
+void input_flush(void);
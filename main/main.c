@@ -1,4 +1,6 @@
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_system.h>
 #include <esp_event.h>
 #include <esp_adc_cal.h>
@@ -7,6 +9,7 @@
 #include <esp_heap_caps.h>
 #include <esp_flash_data_types.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 #include <nvs.h>
 #include <driver/gpio.h>
@@ -18,6 +21,9 @@
 #include <rom/crc.h>
 #endif
 
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
@@ -59,6 +65,31 @@
 
 #define ITEM_COUNT                  ((SCREEN_HEIGHT-32)/52)
 
+// Framebuffer pixel format:
+// - RGB565_LE: host byte order, swapped by the display driver on every refresh
+// - RGB565_BE: the panel's byte order, sent as is
+// - INDEXED8:  8bpp palette indexes, expanded by the display driver (half the memory)
+#define FB_FORMAT_RGB565_LE         0
+#define FB_FORMAT_RGB565_BE         1
+#define FB_FORMAT_INDEXED8          2
+
+#ifndef FB_FORMAT
+#define FB_FORMAT                   FB_FORMAT_RGB565_BE
+#endif
+
+// In indexed mode the first palette entries are given to the exact colors used by the UI,
+// the rest is a 6x6x6 color cube used for the tiles (and any color that doesn't fit).
+#define FB_PALETTE_EXACT            40
+#define FB_PALETTE_CUBE             (FB_PALETTE_EXACT)
+
+// Allocate the framebuffer in PSRAM when present. The display driver streams it out
+// in small bands, and the ~150KB of internal RAM is left to the DMA-capable I/O buffers.
+#ifndef FB_IN_PSRAM
+#define FB_IN_PSRAM                 1
+#endif
+
+#define FB_SIZE                     (SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(fb_pixel_t))
+
 #define ALIGN_ADDRESS(val, alignment) (((val & (alignment-1)) != 0) ? (val & ~(alignment-1)) + alignment : val)
 #define SET_STATUS_LED(on) gpio_set_level(GPIO_NUM_2, on);
 #define RG_MIN(a, b) ({__typeof__(a) _a = (a); __typeof__(b) _b = (b);_a < _b ? _a : _b; })
@@ -74,6 +105,8 @@
 #define FIRMWARE_PATH SDCARD_BASE_PATH "/odroid/firmware"
 #endif
 
+#define FIRMWARE_DEPTH 3    // Levels of subfolders searched under FIRMWARE_PATH
+
 typedef struct
 {
     uint8_t type;
@@ -130,26 +163,277 @@ typedef struct
     bool enabled;
 } dialog_option_t;
 
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+typedef uint8_t fb_pixel_t;
+#else
+typedef uint16_t fb_pixel_t;
+#endif
+
 static odroid_app_t *apps;
 static int apps_count = -1;
 static int apps_max = 4;
 static int apps_seq = 0;
 static int firstAppOffset = 0x100000; // We scan the table to find the real value but this is a reasonable default
-static uint16_t fb[SCREEN_WIDTH * SCREEN_HEIGHT];
+static fb_pixel_t *fb;
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+static uint16_t fb_palette[256]; // Panel byte order
+static UG_COLOR fb_palette_exact[FB_PALETTE_EXACT];
+static int fb_palette_exact_count = 0;
+#endif
 static UG_GUI gui;
 static esp_err_t sdcardret;
 static nvs_handle nvs_h;
 
 static float read_battery(void);
 
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+static void fb_palette_init(void)
+{
+    // Index 0 is black, so that a zeroed framebuffer is a black screen in every format
+    fb_palette_exact[0] = C_BLACK;
+    fb_palette[0] = 0x0000;
+    fb_palette_exact_count = 1;
+
+    for (int r = 0; r < 6; r++)
+        for (int g = 0; g < 6; g++)
+            for (int b = 0; b < 6; b++)
+            {
+                uint16_t color = (r * 31 / 5) << 11 | (g * 63 / 5) << 5 | (b * 31 / 5);
+                fb_palette[FB_PALETTE_CUBE + r * 36 + g * 6 + b] = color << 8 | color >> 8;
+            }
+}
+
+static inline uint8_t fb_palette_nearest(UG_COLOR color)
+{
+    int r = ((color >> 11) * 5 + 15) / 31;
+    int g = (((color >> 5) & 0x3F) * 5 + 31) / 63;
+    int b = ((color & 0x1F) * 5 + 15) / 31;
+    return FB_PALETTE_CUBE + r * 36 + g * 6 + b;
+}
+
+static uint8_t fb_palette_index(UG_COLOR color)
+{
+    static UG_COLOR last_color;
+    static int last_index = -1;
+
+    // Fills and text use the same color for long runs of pixels
+    if (last_index >= 0 && color == last_color)
+        return last_index;
+
+    last_color = color;
+
+    for (last_index = 0; last_index < fb_palette_exact_count; last_index++)
+    {
+        if (fb_palette_exact[last_index] == color)
+            return last_index;
+    }
+
+    if (fb_palette_exact_count < FB_PALETTE_EXACT)
+    {
+        fb_palette_exact[fb_palette_exact_count] = color;
+        fb_palette[fb_palette_exact_count] = color << 8 | color >> 8;
+        return last_index = fb_palette_exact_count++;
+    }
+
+    return last_index = fb_palette_nearest(color);
+}
+#endif
+
+static inline fb_pixel_t fb_color(UG_COLOR color)
+{
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+    return fb_palette_index(color);
+#elif FB_FORMAT == FB_FORMAT_RGB565_BE
+    return color << 8 | color >> 8;
+#else
+    return color;
+#endif
+}
+
+// Same as fb_color but tiles don't get exact palette entries in indexed mode
+static inline fb_pixel_t fb_tile_color(UG_COLOR color)
+{
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+    return fb_palette_nearest(color);
+#else
+    return fb_color(color);
+#endif
+}
+
 static void pset(UG_S16 x, UG_S16 y, UG_COLOR color)
 {
-    fb[y * SCREEN_WIDTH + x] = color;
+    fb[y * SCREEN_WIDTH + x] = fb_color(color);
+}
+
+static inline void fb_fill_row(fb_pixel_t *dst, int count, fb_pixel_t value)
+{
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+    memset(dst, value, count);
+#else
+    // Align to a word then store two pixels at a time
+    if (((uintptr_t)dst & 2) && count > 0)
+    {
+        *dst++ = value;
+        count--;
+    }
+
+    uint32_t *dst32 = (uint32_t *)dst;
+    uint32_t value32 = value << 16 | value;
+
+    for (int i = 0; i < count / 2; i++)
+        dst32[i] = value32;
+
+    if (count & 1)
+        dst[count - 1] = value;
+#endif
+}
+
+static UG_RESULT fb_fill_frame(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR color)
+{
+    // uGUI already ordered the corners
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= SCREEN_WIDTH) x2 = SCREEN_WIDTH - 1;
+    if (y2 >= SCREEN_HEIGHT) y2 = SCREEN_HEIGHT - 1;
+    if (x1 > x2 || y1 > y2) return UG_RESULT_OK;
+
+    fb_pixel_t value = fb_color(color);
+
+    for (int y = y1; y <= y2; y++)
+        fb_fill_row(&fb[y * SCREEN_WIDTH + x1], x2 - x1 + 1, value);
+
+    return UG_RESULT_OK;
+}
+
+static UG_RESULT fb_draw_line(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR color)
+{
+    // Only straight lines are accelerated, uGUI draws the others pixel by pixel
+    if (x1 != x2 && y1 != y2)
+        return UG_RESULT_FAIL;
+
+    return fb_fill_frame(RG_MIN(x1, x2), RG_MIN(y1, y2), RG_MAX(x1, x2), RG_MAX(y1, y2), color);
+}
+
+// Area writes (text) fill a rectangle left to right, top to bottom, one pixel per call
+static struct {
+    fb_pixel_t *dst;
+    int x, y, left, right;
+} fb_area;
+
+static void fb_area_push(UG_COLOR color)
+{
+    *fb_area.dst++ = fb_color(color);
+
+    if (++fb_area.x > fb_area.right)
+    {
+        fb_area.dst += SCREEN_WIDTH - (fb_area.right - fb_area.left + 1);
+        fb_area.x = fb_area.left;
+    }
+}
+
+static void fb_area_push_clipped(UG_COLOR color)
+{
+    if (fb_area.x >= 0 && fb_area.x < SCREEN_WIDTH && fb_area.y >= 0 && fb_area.y < SCREEN_HEIGHT)
+        fb[fb_area.y * SCREEN_WIDTH + fb_area.x] = fb_color(color);
+
+    if (++fb_area.x > fb_area.right)
+    {
+        fb_area.x = fb_area.left;
+        fb_area.y++;
+    }
+}
+
+static void *fb_fill_area(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2)
+{
+    fb_area.x = fb_area.left = x1;
+    fb_area.y = y1;
+    fb_area.right = x2;
+
+    if (x1 < 0 || y1 < 0 || x2 >= SCREEN_WIDTH || y2 >= SCREEN_HEIGHT)
+        return fb_area_push_clipped;
+
+    fb_area.dst = &fb[y1 * SCREEN_WIDTH + x1];
+    return fb_area_push;
+}
+
+// uGUI has already clipped the rectangle, rows are copied in the framebuffer's format
+static UG_RESULT fb_blit(UG_S16 x, UG_S16 y, UG_S16 width, UG_S16 height, const UG_U16 *pixels, UG_S16 stride)
+{
+    for (int row = 0; row < height; row++)
+    {
+        fb_pixel_t *dst = &fb[(y + row) * SCREEN_WIDTH + x];
+        const uint16_t *src = &pixels[row * stride];
+
+#if FB_FORMAT == FB_FORMAT_RGB565_LE
+        memcpy(dst, src, width * 2);
+#elif FB_FORMAT == FB_FORMAT_RGB565_BE
+        for (int i = 0; i < width; i++)
+            dst[i] = src[i] << 8 | src[i] >> 8;
+#else
+        for (int i = 0; i < width; i++)
+            dst[i] = fb_tile_color(src[i]);
+#endif
+    }
+
+    return UG_RESULT_OK;
+}
+
+// Glyph rows are expanded four pixels at a time from a table of every nibble in the
+// current colors. It's rebuilt when the colors change, which is rare within a string.
+typedef struct { fb_pixel_t p[4]; } fb_nibble_t;
+
+static UG_RESULT fb_draw_bits(UG_S16 x, UG_S16 y, UG_S16 width, const UG_U8 *bits, UG_COLOR fc, UG_COLOR bc)
+{
+    static fb_nibble_t lut[16];
+    static UG_COLOR lut_fc, lut_bc;
+    static bool lut_valid = false;
+
+    if (x < 0 || y < 0 || x + width > SCREEN_WIDTH || y >= SCREEN_HEIGHT)
+        return UG_RESULT_FAIL;
+
+    if (!lut_valid || fc != lut_fc || bc != lut_bc)
+    {
+        fb_pixel_t f = fb_color(fc), b = fb_color(bc);
+        for (int n = 0; n < 16; n++)
+            for (int k = 0; k < 4; k++)
+                lut[n].p[k] = (n >> k) & 1 ? f : b;
+        lut_fc = fc;
+        lut_bc = bc;
+        lut_valid = true;
+    }
+
+    fb_pixel_t *dst = &fb[y * SCREEN_WIDTH + x];
+
+    for (; width >= 8; width -= 8, dst += 8)
+    {
+        UG_U8 byte = *bits++;
+        *(fb_nibble_t *)&dst[0] = lut[byte & 0xF];
+        *(fb_nibble_t *)&dst[4] = lut[byte >> 4];
+    }
+
+    for (int k = 0; k < width; k++)
+        dst[k] = lut[(*bits >> (k & 4)) & 0xF].p[k & 3];
+
+    return UG_RESULT_OK;
 }
 
 static void UpdateDisplay(void)
 {
+    // The background tasks may be using the SD Card, which shares the bus on the ODROID-GO
+    odroid_sdcard_bus_take();
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+    ili9341_writeIndexed(fb, fb_palette);
+#elif FB_FORMAT == FB_FORMAT_RGB565_BE
+    ili9341_writeBE(fb);
+#else
     ili9341_writeLE(fb);
+#endif
+    odroid_sdcard_bus_give();
+}
+
+static void DisplayTile(int left, int top, const uint16_t *tile)
+{
+    UG_BlitRGB565(left, top, FIRMWARE_TILE_WIDTH, FIRMWARE_TILE_HEIGHT, tile);
 }
 
 static void DisplayCenter(int top, const char *str)
@@ -163,18 +447,29 @@ static void DisplayCenter(int top, const char *str)
     UG_PutString(left, top + 4 , strncpy(tempstring, str, maxlen));
 }
 
-static void DisplayPage(const char *title, const char *footer)
+static void DisplayTitle(const char *title)
 {
-    UG_FillFrame(0, 0, SCREEN_WIDTH-1, SCREEN_HEIGHT-1, C_WHITE);
     UG_FontSelect(&FONT_8X8);
     UG_SetBackcolor(C_MIDNIGHT_BLUE);
     UG_SetForecolor(C_WHITE);
     DisplayCenter(0, title);
+}
+
+static void DisplayPage(const char *title, const char *footer)
+{
+    UG_FillFrame(0, 0, SCREEN_WIDTH-1, SCREEN_HEIGHT-1, C_WHITE);
+    DisplayTitle(title);
     UG_SetForecolor(C_LIGHT_GRAY);
     DisplayCenter(SCREEN_HEIGHT - 16, footer);
 }
 
-static void DisplayIndicators(int page, int totalPages)
+static int battery_percent(void)
+{
+    int percent = (read_battery() - BATTERY_VMIN) / (BATTERY_VMAX - BATTERY_VMIN) * 100.f;
+    return RG_MIN(100, RG_MAX(0, percent));
+}
+
+static void DisplayIndicators(int page, int totalPages, int battery)
 {
     char tempstring[128];
 
@@ -186,8 +481,7 @@ static void DisplayIndicators(int page, int totalPages)
     UG_PutString(4, 4, tempstring);
 
     // Battery indicator
-    int percent = (read_battery() - BATTERY_VMIN) / (BATTERY_VMAX - BATTERY_VMIN) * 100.f;
-    sprintf(tempstring, "%d%%", RG_MIN(100, RG_MAX(0, percent)));
+    sprintf(tempstring, "%d%%", battery);
     UG_PutString(SCREEN_WIDTH - (9 * strlen(tempstring)) - 4, 4, tempstring);
 }
 
@@ -270,10 +564,61 @@ static void DisplayRow(int line, const char *line1, const char *line2, uint16_t
 
     if (tile) // Draw Tile at the end
     {
-        for (int i = 0 ; i < FIRMWARE_TILE_HEIGHT; ++i)
-            for (int j = 0; j < FIRMWARE_TILE_WIDTH; ++j)
-                UG_DrawPixel(margin + j, top + 2 + i, tile[i * FIRMWARE_TILE_WIDTH + j]);
+        DisplayTile(margin, top + 2, tile);
+    }
+}
+
+// Moves the selection of a list `count` times in the direction of `btn`, wrapping around
+static int ListNavigate(int currentItem, int itemCount, int btn, int count)
+{
+    while (count-- > 0)
+    {
+        int page = (currentItem / ITEM_COUNT) * ITEM_COUNT;
+
+        if (btn == ODROID_INPUT_DOWN)
+        {
+            if (++currentItem >= itemCount) currentItem = 0;
+        }
+        else if (btn == ODROID_INPUT_UP)
+        {
+            if (--currentItem < 0) currentItem = itemCount - 1;
+        }
+        else if (btn == ODROID_INPUT_RIGHT)
+        {
+            if (page + ITEM_COUNT < itemCount) currentItem = page + ITEM_COUNT;
+            else currentItem = 0;
+        }
+        else if (btn == ODROID_INPUT_LEFT)
+        {
+            if (page - ITEM_COUNT >= 0) currentItem = page - ITEM_COUNT;
+            else currentItem = (itemCount - 1) / ITEM_COUNT * ITEM_COUNT;
+        }
+    }
+
+    return currentItem;
+}
+
+// Returns the first item of the list window that shows currentItem. With hardware scrolling
+// the list moves one row at a time and only the new row is sent, otherwise by whole pages.
+static int ScrollList(int firstItem, int currentItem)
+{
+    const int itemHeight = 52;
+    int newFirst = (currentItem / ITEM_COUNT) * ITEM_COUNT;
+
+    if (LCD_HW_VSCROLL && firstItem >= 0)
+    {
+        if (currentItem >= firstItem && currentItem < firstItem + ITEM_COUNT)
+            newFirst = firstItem;
+        else if (currentItem == firstItem - 1)
+            newFirst = firstItem - 1;
+        else if (currentItem == firstItem + ITEM_COUNT)
+            newFirst = firstItem + 1;
+
+        if (newFirst != firstItem && abs(newFirst - firstItem) == 1)
+            ili9341_scroll(16, ITEM_COUNT * itemHeight, (newFirst - firstItem) * itemHeight);
     }
+
+    return newFirst;
 }
 
 //---------------
@@ -316,13 +661,173 @@ static void *safe_alloc(size_t size)
     return ptr;
 }
 
+// Internal DMA-capable memory avoids the bounce buffers of the SD Card and flash drivers
+static void *io_alloc(size_t size)
+{
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    if (!ptr)
+        ptr = safe_alloc(size);
+    return ptr;
+}
+
+// Firmware files are read without stdio, always from sector-aligned offsets into a DMA-capable
+// buffer. FatFs then reads whole sectors straight into it, instead of copying through the FILE
+// buffer and its own sector window, and the SD driver never bounces a misaligned transfer.
+// Refills carry the unread tail over so the file is only ever read forward, and seeking is
+// left for the reads that actually jump: without the FatFs cluster link map (fast seek,
+// read-only files only) a seek backward walks the FAT chain from the start of the file.
+typedef struct
+{
+    int fd;
+    size_t fileSize;
+    size_t offset;      // Where the descriptor is
+    uint8_t *buffer;
+    size_t bufferSize;
+    size_t start;       // File offset of buffer[0]
+    size_t length;      // Bytes in buffer
+    size_t position;
+    bool eof;           // The last read stopped at the end of the file
+    size_t readBytes;
+    int64_t readTime;
+} fw_file_t;
+
+static bool fw_file_open(fw_file_t *file, const char *path, size_t bufferSize)
+{
+    memset(file, 0, sizeof(*file));
+
+    struct stat st;
+
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0)
+        return false;
+
+    // Seeking to the end for the size would walk the whole FAT chain
+    if (fstat(file->fd, &st) != 0)
+    {
+        close(file->fd);
+        file->fd = -1;
+        return false;
+    }
+
+    file->fileSize = st.st_size;
+    file->bufferSize = ALIGN_ADDRESS(bufferSize, 512);
+    file->buffer = io_alloc(file->bufferSize);
+    return true;
+}
+
+static void fw_file_close(fw_file_t *file)
+{
+    if (file->fd >= 0)
+        close(file->fd);
+    free(file->buffer);
+    file->fd = -1;
+    file->buffer = NULL;
+}
+
+static void fw_file_seek(fw_file_t *file, size_t position)
+{
+    file->position = position;
+}
+
+static size_t fw_file_tell(fw_file_t *file)
+{
+    return file->position;
+}
+
+// Returns up to *length bytes at the current position and moves past them. The data is 4-byte
+// aligned and stays valid until the next call, *length is 0 at the end of the file or on error.
+static const void *fw_file_next(fw_file_t *file, size_t *length)
+{
+    bool inside = file->position >= file->start && file->position < file->start + file->length;
+    size_t available = inside ? file->start + file->length - file->position : 0;
+
+    // Also refill when only the tail of the buffer is left, rather than returning a short chunk
+    if (!inside || (available < *length && !file->eof))
+    {
+        size_t start = file->position & ~511;
+        size_t size = file->position - start + *length;
+        size_t keep = 0;
+
+        size = ALIGN_ADDRESS(size, 512);
+        if (size > file->bufferSize)
+            size = file->bufferSize;
+
+        // The sectors already in the buffer are moved to the front, a whole number of them
+        if (inside && start >= file->start)
+        {
+            keep = file->start + file->length - start;
+            memmove(file->buffer, file->buffer + (start - file->start), keep);
+        }
+
+        int64_t time = esp_timer_get_time();
+        ssize_t count = 0;
+
+        if (file->offset != start + keep)
+            file->offset = lseek(file->fd, start + keep, SEEK_SET);
+
+        if (file->offset == start + keep && size > keep)
+            count = read(file->fd, file->buffer + keep, size - keep);
+
+        if (count < 0)
+        {
+            file->offset = SIZE_MAX; // Unknown, seek before the next read
+            count = 0;
+        }
+        file->offset += count;
+
+        file->readTime += esp_timer_get_time() - time;
+        file->start = start;
+        file->length = keep + count;
+        file->eof = file->length < size;
+        file->readBytes += count;
+
+        available = file->start + file->length > file->position ? file->start + file->length - file->position : 0;
+    }
+
+    // Firmware data usually starts at 2 mod 4 (the header is 22 bytes on the MRGC-G32) and
+    // spi_flash_write would copy a misaligned source through a bounce buffer. Shifting what's
+    // left in the buffer by up to 3 bytes keeps the data aligned, the next reads stay aligned
+    // too because the buffer's end in the file doesn't move.
+    size_t misalign = (file->position - file->start) & 3;
+    if (available > 0 && misalign)
+    {
+        memmove(file->buffer, file->buffer + misalign, file->length - misalign);
+        file->start += misalign;
+        file->length -= misalign;
+    }
+
+    const void *data = file->buffer + (file->position - file->start);
+
+    if (*length > available)
+        *length = available;
+    file->position += *length;
+
+    return data;
+}
+
+static bool fw_file_read(fw_file_t *file, void *dest, size_t size)
+{
+    while (size > 0)
+    {
+        size_t length = size;
+        const void *data = fw_file_next(file, &length);
+        if (length == 0)
+            return false;
+        memcpy(dest, data, length);
+        dest = (uint8_t *)dest + length;
+        size -= length;
+    }
+    return true;
+}
+
 static void cleanup_and_restart(void)
 {
     gpio_set_direction(GPIO_NUM_2, GPIO_MODE_INPUT);
     odroid_sdcard_close();
     nvs_close(nvs_h);
     nvs_flash_deinit_partition(MFW_NVS_PARTITION);
-    ili9341_writeLE(memset(fb, 0, sizeof(fb)));
+    memset(fb, 0, FB_SIZE);
+    UpdateDisplay();
     ili9341_deinit();
     esp_restart();
 }
@@ -579,7 +1084,7 @@ static void defrag_flash(void)
     DisplayHeader("Making some space...");
     UpdateDisplay();
 
-    void *dataBuffer = safe_alloc(FLASH_BLOCK_SIZE);
+    void *dataBuffer = io_alloc(FLASH_BLOCK_SIZE);
 
     for (int i = 0; i < apps_count; i++)
     {
@@ -689,17 +1194,13 @@ static odroid_fw_t *firmware_get_info(const char *filename)
 {
     odroid_fw_t *outData = safe_alloc(sizeof(odroid_fw_t));
 
-    FILE* file = fopen(filename, "rb");
-    if (!file)
+    fw_file_t file;
+    if (!fw_file_open(&file, filename, sizeof(outData->header)))
         goto firmware_get_info_err;
 
-    size_t file_size;
+    size_t file_size = file.fileSize;
 
-    fseek(file, 0, SEEK_END);
-    file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (!fread(&outData->header, sizeof(outData->header), 1, file))
+    if (!fw_file_read(&file, &outData->header, sizeof(outData->header)))
     {
         goto firmware_get_info_err;
     }
@@ -712,19 +1213,19 @@ static odroid_fw_t *firmware_get_info(const char *filename)
     outData->header.description[sizeof(outData->header.description) - 1] = 0;
     outData->parts_count = 0;
     outData->flashSize = 0;
-    outData->dataOffset = ftell(file);
+    outData->dataOffset = fw_file_tell(&file);
     outData->fileSize = file_size;
 
-    while (ftell(file) < (file_size - 4))
+    while (fw_file_tell(&file) < (file_size - 4))
     {
         // Partition information
         odroid_partition_t *part = &outData->parts[outData->parts_count];
 
-        if (fread(part, sizeof(odroid_partition_t), 1, file) != 1)
+        if (!fw_file_read(&file, part, sizeof(odroid_partition_t)))
             goto firmware_get_info_err;
 
         // Check if dataLength is valid
-        if (ftell(file) + part->dataLength > file_size || part->dataLength > part->length)
+        if (fw_file_tell(&file) + part->dataLength > file_size || part->dataLength > part->length)
             goto firmware_get_info_err;
 
         // Check partition subtype
@@ -737,14 +1238,14 @@ static odroid_fw_t *firmware_get_info(const char *filename)
         outData->flashSize += part->length;
         outData->parts_count++;
 
-        fseek(file, part->dataLength, SEEK_CUR);
+        fw_file_seek(&file, fw_file_tell(&file) + part->dataLength);
     }
 
     if (outData->parts_count >= FIRMWARE_PARTS_MAX)
         goto firmware_get_info_err;
 
-    fseek(file, file_size - sizeof(outData->checksum), SEEK_SET);
-    fread(&outData->checksum, sizeof(outData->checksum), 1, file);
+    fw_file_seek(&file, file_size - sizeof(outData->checksum));
+    fw_file_read(&file, &outData->checksum, sizeof(outData->checksum));
 
     // We try to steal some unused space if possible, otherwise we might waste up to 48K
     odroid_partition_t *part = &outData->parts[outData->parts_count - 1];
@@ -763,21 +1264,73 @@ static odroid_fw_t *firmware_get_info(const char *filename)
     outData->flashSize += nvs_part->length;
     outData->parts_count++;
 
-    fclose(file);
+    fw_file_close(&file);
     return outData;
 
 firmware_get_info_err:
     free(outData);
-    fclose(file);
+    fw_file_close(&file);
     return NULL;
 }
 
 
+// The identity (name, size, mtime, checksum) of the last few files that passed verification
+// is kept in NVS. Installing one of them again skips the verification read.
+#define VERIFIED_MEMO_COUNT 8
+
+typedef struct
+{
+    uint32_t nameHash;  // Of the name relative to FIRMWARE_PATH, like the index's
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t checksum;
+} verified_file_t;
+
+// Files in different subfolders can share a name, the path under FIRMWARE_PATH tells them apart
+static const char *firmware_relative_name(const char *fullPath)
+{
+    const size_t length = strlen(FIRMWARE_PATH "/");
+    return strncmp(fullPath, FIRMWARE_PATH "/", length) == 0 ? fullPath + length : fullPath;
+}
+
+static bool verified_memo_find(const verified_file_t *file)
+{
+    verified_file_t memo[VERIFIED_MEMO_COUNT];
+    size_t size = sizeof(memo);
+
+    if (nvs_get_blob(nvs_h, "verified", memo, &size) != ESP_OK)
+        return false;
+
+    for (int i = 0; i < size / sizeof(verified_file_t); i++)
+    {
+        if (memcmp(&memo[i], file, sizeof(verified_file_t)) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static void verified_memo_add(const verified_file_t *file)
+{
+    verified_file_t memo[VERIFIED_MEMO_COUNT];
+    size_t size = sizeof(memo);
+
+    if (nvs_get_blob(nvs_h, "verified", memo, &size) != ESP_OK)
+        size = 0;
+
+    // Newest first, the oldest falls off the end
+    int count = RG_MIN(size / sizeof(verified_file_t) + 1, VERIFIED_MEMO_COUNT);
+    memmove(&memo[1], &memo[0], (count - 1) * sizeof(verified_file_t));
+    memo[0] = *file;
+
+    nvs_set_blob(nvs_h, "verified", memo, count * sizeof(verified_file_t));
+    nvs_commit(nvs_h);
+}
+
 static void flash_firmware(const char *fullPath)
 {
     odroid_app_t *app = memset(&apps[apps_count], 0x00, sizeof(*app));
     odroid_fw_t *fw = firmware_get_info(fullPath);
-    void *dataBuffer = safe_alloc(FLASH_BLOCK_SIZE);
     char tempstring[128];
 
     ESP_LOGI(__func__, "Flashing file: %s", fullPath);
@@ -791,8 +1344,9 @@ static void flash_firmware(const char *fullPath)
     if (!fw)
     {
         DisplayError("INVALID FIRMWARE FILE"); // To do: Make it show what is invalid
+        input_flush();
         while (input_wait_for_button_press(-1) != ODROID_INPUT_B);
-        free(dataBuffer), free(fw);
+        free(fw);
         return;
     }
 
@@ -800,8 +1354,9 @@ static void flash_firmware(const char *fullPath)
     if (currentFlashAddress == -1)
     {
         DisplayError("NOT ENOUGH FREE SPACE");
+        input_flush();
         while (input_wait_for_button_press(-1) != ODROID_INPUT_B);
-        free(dataBuffer), free(fw);
+        free(fw);
         return;
     }
 
@@ -823,13 +1378,12 @@ static void flash_firmware(const char *fullPath)
     int tileLeft = (SCREEN_WIDTH / 2) - (FIRMWARE_TILE_WIDTH / 2);
     int tileTop = (16 + 16 + 16);
 
-    for (int i = 0 ; i < FIRMWARE_TILE_HEIGHT; ++i)
-        for (int j = 0; j < FIRMWARE_TILE_WIDTH; ++j)
-            UG_DrawPixel(tileLeft + j, tileTop + i, app->tile[i * FIRMWARE_TILE_WIDTH + j]);
+    DisplayTile(tileLeft, tileTop, app->tile);
 
     UG_DrawFrame(tileLeft - 1, tileTop - 1, tileLeft + FIRMWARE_TILE_WIDTH, tileTop + FIRMWARE_TILE_HEIGHT, C_BLACK);
     UpdateDisplay();
 
+    input_flush();
     while (1)
     {
         int btn = input_wait_for_button_press(-1);
@@ -843,35 +1397,56 @@ static void flash_firmware(const char *fullPath)
 
     SET_STATUS_LED(1);
 
-    FILE *file = fopen(fullPath, "rb");
-    if (file == NULL)
+    // One extra sector so that a whole block is available whatever the alignment in the file
+    fw_file_t file;
+    if (!fw_file_open(&file, fullPath, FLASH_BLOCK_SIZE + 512))
     {
         panic_abort("FILE OPEN ERROR");
     }
 
-    uint32_t checksum = 0;
-    while (true)
+    struct stat st;
+    verified_file_t identity = {
+        .nameHash = odroid_sdcard_name_hash(firmware_relative_name(fullPath)),
+        .checksum = fw->checksum,
+    };
+    if (stat(fullPath, &st) == 0) // fstat doesn't fill st_mtime on FAT
+    {
+        identity.size = st.st_size;
+        identity.mtime = st.st_mtime;
+    }
+
+    if (identity.mtime && verified_memo_find(&identity))
+    {
+        ESP_LOGI(__func__, "File was verified before, skipping checksum: %#010x", fw->checksum);
+    }
+    else
     {
-        size_t count = fread(dataBuffer, 1, FLASH_BLOCK_SIZE, file);
-        if (ftell(file) == fw->fileSize)
+        uint32_t checksum = 0;
+        while (fw_file_tell(&file) < fw->fileSize - 4)
         {
-            count -= 4;
-        }
+            size_t count = fw->fileSize - 4 - fw_file_tell(&file);
+            const void *data = fw_file_next(&file, &count);
+            if (count == 0)
+            {
+                panic_abort("DATA READ ERROR");
+            }
 
-        checksum = crc32_le(checksum, dataBuffer, count);
+            checksum = crc32_le(checksum, data, count);
+        }
 
-        if (count < FLASH_BLOCK_SIZE) break;
-    }
+        if (checksum != fw->checksum)
+        {
+            ESP_LOGE(__func__, "Checksum mismatch: expected: %#010x, computed:%#010x", fw->checksum, checksum);
+            panic_abort("CHECKSUM MISMATCH ERROR");
+        }
+        ESP_LOGI(__func__, "Checksum OK: %#010x", checksum);
 
-    if (checksum != fw->checksum)
-    {
-        ESP_LOGE(__func__, "Checksum mismatch: expected: %#010x, computed:%#010x", fw->checksum, checksum);
-        panic_abort("CHECKSUM MISMATCH ERROR");
+        if (identity.mtime)
+            verified_memo_add(&identity);
     }
-    ESP_LOGI(__func__, "Checksum OK: %#010x", checksum);
 
     // restore location to end of description
-    fseek(file, fw->dataOffset, SEEK_SET);
+    fw_file_seek(&file, fw->dataOffset);
 
     app->magic = APP_TABLE_MAGIC;
     app->startOffset = currentFlashAddress;
@@ -882,7 +1457,7 @@ static void flash_firmware(const char *fullPath)
         odroid_partition_t *slot = &app->parts[i];
 
         // Skip header, firmware_get_info prepared everything for us
-        fseek(file, sizeof(odroid_partition_t), SEEK_CUR);
+        fw_file_seek(&file, fw_file_tell(&file) + sizeof(odroid_partition_t));
 
         SET_STATUS_LED(0);
 
@@ -904,13 +1479,13 @@ static void flash_firmware(const char *fullPath)
 
         if (slot->dataLength > 0)
         {
-            size_t nextEntry = ftell(file) + slot->dataLength;
+            size_t nextEntry = fw_file_tell(&file) + slot->dataLength;
 
             SET_STATUS_LED(1);
 
             // Write data
             int totalCount = 0;
-            for (int offset = 0; offset < slot->dataLength; offset += FLASH_BLOCK_SIZE)
+            for (int offset = 0; offset < slot->dataLength; offset = totalCount)
             {
                 sprintf(tempstring, "Writing (%d/%d)", i+1, app->parts_count);
                 ESP_LOGI(__func__, "%s", tempstring);
@@ -918,19 +1493,20 @@ static void flash_firmware(const char *fullPath)
                 DisplayMessage(tempstring);
 
                 // read
-                size_t count = fread(dataBuffer, 1, FLASH_BLOCK_SIZE, file);
-                if (count <= 0)
+                size_t count = slot->dataLength - offset;
+                if (count > FLASH_BLOCK_SIZE)
                 {
-                    panic_abort("DATA READ ERROR");
+                    count = FLASH_BLOCK_SIZE;
                 }
 
-                if (offset + count >= slot->dataLength)
+                const void *data = fw_file_next(&file, &count);
+                if (count == 0)
                 {
-                    count = slot->dataLength - offset;
+                    panic_abort("DATA READ ERROR");
                 }
 
                 // flash
-                if (spi_flash_write(currentFlashAddress + offset, dataBuffer, count) != ESP_OK)
+                if (spi_flash_write(currentFlashAddress + offset, data, count) != ESP_OK)
         		{
         			ESP_LOGE(__func__, "spi_flash_write failed. address=%#08x", currentFlashAddress + offset);
                     panic_abort("WRITE ERROR");
@@ -947,7 +1523,7 @@ static void flash_firmware(const char *fullPath)
                 panic_abort("DATA SIZE ERROR");
             }
 
-            fseek(file, nextEntry, SEEK_SET);
+            fw_file_seek(&file, nextEntry);
             // TODO: verify
         }
 
@@ -956,9 +1532,11 @@ static void flash_firmware(const char *fullPath)
         currentFlashAddress += slot->length;
     }
 
-    fclose(file);
+    ESP_LOGI(__func__, "Read %dKB in %dms (%dKB/s)", file.readBytes / 1024, (int)(file.readTime / 1000),
+        file.readTime > 0 ? (int)(file.readBytes * 1000000LL / 1024 / file.readTime) : 0);
+
+    fw_file_close(&file);
     free(fw);
-    free(dataBuffer);
 
     // 64K align our endOffset
     app->endOffset = ALIGN_ADDRESS(currentFlashAddress, FLASH_BLOCK_SIZE) - 1;
@@ -974,6 +1552,8 @@ static void flash_firmware(const char *fullPath)
     DisplayFooter("[B] Go Back  |  [A] Boot");
     UpdateDisplay();
 
+    // Presses made during the install would answer right away
+    input_flush();
     while (1)
     {
         int btn = input_wait_for_button_press(-1);
@@ -986,28 +1566,683 @@ static void flash_firmware(const char *fullPath)
 }
 
 
-static char *ui_choose_file(const char *path)
+// Parsed rows are also remembered across boots in an index next to the firmware files,
+// keyed by name, size and mtime. The index holds the small fields and the tiles are
+// appended to a separate file, so loading the index is a single small read.
+#define FW_INDEX_FILE "/.mfw_cache.idx"
+#define FW_TILES_FILE "/.mfw_cache.bin"
+#define FW_LIST_FILE "/.mfw_cache.lst"
+#define FW_LIST_TEMP_FILE "/.mfw_cache.tmp"
+#define FW_LIST_NEW_FILE "/.mfw_cache.new"
+#define FW_INDEX_MAGIC 0x4D465749 // MFWI, bump on any format change
+#define FW_INDEX_MAX_ENTRIES 65536
+
+typedef struct
 {
-    char tempstring[128];
+    uint32_t nameHash;
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t flashSize;
+    uint32_t tileOffset;
+    uint32_t valid;
+} fw_index_entry_t;
+
+static struct
+{
+    SemaphoreHandle_t lock;     // Guards the entries and both files
+    char path[128];
+    fw_index_entry_t *entries;
+    int count;
+    int capacity;
+    bool dirty;
+} fw_index;
+
+static void fw_index_load(const char *path)
+{
+    char fileName[160];
+    uint32_t header[2];
 
-    // Check SD card
-    if (sdcardret != ESP_OK)
-    {
-        DisplayPage("Error", "Error");
-        DisplayError("SD CARD ERROR");
-        vTaskDelay(200);
+    if (!fw_index.lock)
+        fw_index.lock = xSemaphoreCreateMutex();
+
+    xSemaphoreTake(fw_index.lock, portMAX_DELAY);
+
+    if (fw_index.entries && strcmp(fw_index.path, path) == 0)
+        goto fw_index_load_done;
+
+    free(fw_index.entries);
+    fw_index.entries = NULL;
+    fw_index.count = fw_index.capacity = 0;
+    fw_index.dirty = false;
+    strncpy(fw_index.path, path, sizeof(fw_index.path) - 1);
+
+    sprintf(fileName, "%s" FW_INDEX_FILE, path);
+    FILE *fp = fopen(fileName, "rb");
+    struct stat st;
+
+    // The count must match the file's size exactly, anything else is treated as no index
+    if (fp && fread(header, sizeof(header), 1, fp) == 1 && header[0] == FW_INDEX_MAGIC
+        && header[1] <= FW_INDEX_MAX_ENTRIES && fstat(fileno(fp), &st) == 0
+        && st.st_size == sizeof(header) + header[1] * sizeof(fw_index_entry_t))
+    {
+        size_t capacity = header[1] + 16;
+        fw_index.entries = heap_caps_malloc(capacity * sizeof(fw_index_entry_t), MALLOC_CAP_SPIRAM);
+        if (!fw_index.entries)
+            fw_index.entries = malloc(capacity * sizeof(fw_index_entry_t));
+        if (fw_index.entries)
+        {
+            fw_index.capacity = capacity;
+            fw_index.count = fread(fw_index.entries, sizeof(fw_index_entry_t), header[1], fp);
+        }
+    }
+    if (fp)
+        fclose(fp);
+
+    ESP_LOGI(__func__, "Loaded %d cached firmware entries", fw_index.count);
+
+fw_index_load_done:
+    xSemaphoreGive(fw_index.lock);
+}
+
+static int hash_cmp(const void *a, const void *b)
+{
+    uint32_t ha = *(const uint32_t *)a;
+    uint32_t hb = *(const uint32_t *)b;
+    return ha < hb ? -1 : ha > hb;
+}
+
+// Drops the entries of files that are gone and writes the index if anything changed. When
+// most of the tiles file is made of stale tiles, both files are started over instead.
+static void fw_index_save(odroid_sdcard_dir_t *dir)
+{
+    int count = odroid_sdcard_dir_count(dir);
+    uint32_t *hashes = safe_alloc((count + 1) * sizeof(uint32_t));
+    char fileName[160];
+    int live = 0;
+
+    for (int j = 0; j < count; j++)
+        hashes[j] = odroid_sdcard_dir_hash(dir, j);
+
+    qsort(hashes, count, sizeof(uint32_t), &hash_cmp);
+
+    xSemaphoreTake(fw_index.lock, portMAX_DELAY);
+
+    for (int i = 0; i < fw_index.count; i++)
+    {
+        if (bsearch(&fw_index.entries[i].nameHash, hashes, count, sizeof(uint32_t), &hash_cmp))
+            fw_index.entries[live++] = fw_index.entries[i];
+    }
+
+    free(hashes);
+
+    fw_index.dirty |= live != fw_index.count;
+    fw_index.count = live;
+
+    struct stat st;
+    sprintf(fileName, "%s" FW_TILES_FILE, fw_index.path);
+    if (stat(fileName, &st) == 0 && st.st_size > (live + 16) * 2 * FIRMWARE_TILE_WIDTH * FIRMWARE_TILE_HEIGHT * 2)
+    {
+        ESP_LOGI(__func__, "Tiles file is mostly stale, starting over");
+        remove(fileName);
+        fw_index.count = 0;
+        fw_index.dirty = true;
+    }
+
+    if (fw_index.dirty)
+    {
+        uint32_t header[2] = {FW_INDEX_MAGIC, fw_index.count};
+
+        sprintf(fileName, "%s" FW_INDEX_FILE, fw_index.path);
+        FILE *fp = fopen(fileName, "wb");
+        if (fp)
+        {
+            fwrite(header, sizeof(header), 1, fp);
+            fwrite(fw_index.entries, sizeof(fw_index_entry_t), fw_index.count, fp);
+            fclose(fp);
+        }
+        fw_index.dirty = false;
+    }
+
+    xSemaphoreGive(fw_index.lock);
+}
+
+static bool fw_index_get(const char *fileName, const struct stat *st, bool *valid, size_t *flashSize, uint16_t *tile)
+{
+    uint32_t hash = odroid_sdcard_name_hash(fileName);
+    char tilesPath[160];
+    bool found = false;
+
+    xSemaphoreTake(fw_index.lock, portMAX_DELAY);
+
+    for (int i = 0; i < fw_index.count; i++)
+    {
+        fw_index_entry_t *entry = &fw_index.entries[i];
+        if (entry->nameHash != hash || entry->size != st->st_size || entry->mtime != st->st_mtime)
+            continue;
+
+        found = true;
+        *valid = entry->valid;
+        *flashSize = entry->flashSize;
+
+        if (entry->valid)
+        {
+            sprintf(tilesPath, "%s" FW_TILES_FILE, fw_index.path);
+            FILE *fp = fopen(tilesPath, "rb");
+            found = fp && fseek(fp, entry->tileOffset, SEEK_SET) == 0
+                    && fread(tile, FIRMWARE_TILE_WIDTH * FIRMWARE_TILE_HEIGHT * 2, 1, fp) == 1;
+            if (fp)
+                fclose(fp);
+        }
+        break;
+    }
+
+    xSemaphoreGive(fw_index.lock);
+
+    return found;
+}
+
+static void fw_index_put(const char *fileName, const struct stat *st, bool valid, size_t flashSize, const uint16_t *tile)
+{
+    fw_index_entry_t entry = {
+        .nameHash = odroid_sdcard_name_hash(fileName),
+        .size = st->st_size,
+        .mtime = st->st_mtime,
+        .flashSize = flashSize,
+        .valid = valid,
+    };
+    char tilesPath[160];
+    int slot;
+
+    xSemaphoreTake(fw_index.lock, portMAX_DELAY);
+
+    if (valid)
+    {
+        sprintf(tilesPath, "%s" FW_TILES_FILE, fw_index.path);
+        FILE *fp = fopen(tilesPath, "ab");
+        if (!fp)
+            goto fw_index_put_done;
+        fseek(fp, 0, SEEK_END);
+        entry.tileOffset = ftell(fp);
+        bool written = fwrite(tile, FIRMWARE_TILE_WIDTH * FIRMWARE_TILE_HEIGHT * 2, 1, fp) == 1;
+        fclose(fp);
+        if (!written)
+            goto fw_index_put_done;
+    }
+
+    // Replace the entry of a file that changed
+    for (slot = 0; slot < fw_index.count; slot++)
+    {
+        if (fw_index.entries[slot].nameHash == entry.nameHash)
+            break;
+    }
+
+    if (slot == fw_index.capacity)
+    {
+        fw_index.capacity += 64;
+        fw_index_entry_t *entries = heap_caps_realloc(fw_index.entries, fw_index.capacity * sizeof(fw_index_entry_t), MALLOC_CAP_SPIRAM);
+        if (!entries)
+            entries = realloc(fw_index.entries, fw_index.capacity * sizeof(fw_index_entry_t));
+        if (!entries)
+            panic_abort("MEMORY ALLOCATION ERROR");
+        fw_index.entries = entries;
+    }
+
+    fw_index.entries[slot] = entry;
+    if (slot == fw_index.count)
+        fw_index.count++;
+    fw_index.dirty = true;
+
+fw_index_put_done:
+    xSemaphoreGive(fw_index.lock);
+}
+
+// The file picker's rows are parsed once and kept in PSRAM. A background task on the
+// other core parses the pages around the visible one while the user looks at it, so
+// flipping pages doesn't wait on the SD Card. Entries far from the view are dropped.
+typedef struct
+{
+    bool valid;
+    size_t flashSize;
+    uint16_t tile[FIRMWARE_TILE_WIDTH * FIRMWARE_TILE_HEIGHT];
+} fw_cache_entry_t;
+
+static struct
+{
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t busy;     // Held by the task while it uses the listing or the SD Card
+    TaskHandle_t task;
+    const char *path;
+    odroid_sdcard_dir_t *dir;
+    int count;
+    int first;          // First visible item
+    int generation;     // Changes every time the list is opened or closed
+    fw_cache_entry_t **entries;
+} fw_cache;
+
+static fw_cache_entry_t *fw_cache_load(const char *path, const char *fileName)
+{
+    fw_cache_entry_t *entry = heap_caps_malloc(sizeof(fw_cache_entry_t), MALLOC_CAP_SPIRAM);
+    char fullPath[128 + 256]; // Paths are kept in 128 bytes, names can be up to 255 characters
+
+    if (!entry)
+        entry = safe_alloc(sizeof(fw_cache_entry_t));
+
+    snprintf(fullPath, sizeof(fullPath), "%s/%s", path, fileName);
+
+    struct stat st;
+    bool indexed = stat(fullPath, &st) == 0;
+
+    if (indexed && fw_index_get(fileName, &st, &entry->valid, &entry->flashSize, entry->tile))
+        return entry;
+
+    odroid_fw_t *fw = firmware_get_info(fullPath);
+    entry->valid = fw != NULL;
+    if (fw)
+    {
+        entry->flashSize = fw->flashSize;
+        memcpy(entry->tile, fw->header.tile, sizeof(entry->tile));
+    }
+    free(fw);
+
+    if (indexed)
+        fw_index_put(fileName, &st, entry->valid, entry->flashSize, entry->tile);
+
+    return entry;
+}
+
+static void fw_cache_task(void *arg)
+{
+    char fileName[256];
+    char path[128];
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (true)
+        {
+            odroid_sdcard_dir_t *dir = NULL;
+            int index = -1;
+
+            // A large listing may read the SD Card for the name, the lock is released meanwhile
+            // so that the picker isn't blocked. Closing the cache waits for the task instead.
+            xSemaphoreTake(fw_cache.busy, portMAX_DELAY);
+            xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+
+            int generation = fw_cache.generation;
+
+            // The next page first, then the previous one, they're one press away
+            for (int i = ITEM_COUNT; i < ITEM_COUNT * 3 && fw_cache.entries; i++)
+            {
+                int item = fw_cache.first + (i < ITEM_COUNT * 2 ? i : ITEM_COUNT * 2 - 1 - i);
+                if (item >= 0 && item < fw_cache.count && !fw_cache.entries[item])
+                {
+                    index = item;
+                    dir = fw_cache.dir;
+                    strncpy(path, fw_cache.path, sizeof(path) - 1);
+                    break;
+                }
+            }
+
+            xSemaphoreGive(fw_cache.lock);
+
+            if (index < 0)
+            {
+                xSemaphoreGive(fw_cache.busy);
+                break;
+            }
+
+            odroid_sdcard_bus_take();
+            odroid_sdcard_dir_name(dir, index, fileName, sizeof(fileName));
+            fw_cache_entry_t *entry = fw_cache_load(path, fileName);
+            odroid_sdcard_bus_give();
+
+            xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+            if (generation == fw_cache.generation && !fw_cache.entries[index])
+            {
+                fw_cache.entries[index] = entry;
+                entry = NULL;
+            }
+            xSemaphoreGive(fw_cache.lock);
+            xSemaphoreGive(fw_cache.busy);
+
+            free(entry);
+        }
+    }
+}
+
+static void fw_cache_open(const char *path, odroid_sdcard_dir_t *dir)
+{
+    int count = odroid_sdcard_dir_count(dir);
+
+    if (!fw_cache.lock)
+    {
+        fw_cache.lock = xSemaphoreCreateMutex();
+        fw_cache.busy = xSemaphoreCreateMutex();
+        xTaskCreatePinnedToCore(&fw_cache_task, "fw_cache_task", 1024 * 6, NULL, 1, &fw_cache.task, 1);
+    }
+
+    fw_index_load(path);
+
+    xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+    fw_cache.path = path;
+    fw_cache.dir = dir;
+    fw_cache.count = count;
+    fw_cache.first = 0;
+    fw_cache.entries = calloc(count + 1, sizeof(fw_cache_entry_t *));
+    fw_cache.generation++;
+    xSemaphoreGive(fw_cache.lock);
+}
+
+// Follows a list that files were appended to, the existing entries stay valid
+static void fw_cache_grow(int count)
+{
+    xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+    fw_cache_entry_t **entries = realloc(fw_cache.entries, (count + 1) * sizeof(fw_cache_entry_t *));
+    if (!entries)
+        panic_abort("MEMORY ALLOCATION ERROR");
+    memset(&entries[fw_cache.count], 0, (count + 1 - fw_cache.count) * sizeof(fw_cache_entry_t *));
+    fw_cache.entries = entries;
+    fw_cache.count = count;
+    xSemaphoreGive(fw_cache.lock);
+
+    xTaskNotifyGive(fw_cache.task);
+}
+
+// The task is idle once this returns, until the next fw_cache_open
+static void fw_cache_close(void)
+{
+    // The listing is closed after this, the task must be done with it
+    xSemaphoreTake(fw_cache.busy, portMAX_DELAY);
+    xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+    fw_index_save(fw_cache.dir);
+    for (int i = 0; i < fw_cache.count; i++)
+        free(fw_cache.entries[i]);
+    free(fw_cache.entries);
+    fw_cache.entries = NULL;
+    fw_cache.count = 0;
+    fw_cache.generation++;
+    xSemaphoreGive(fw_cache.lock);
+    xSemaphoreGive(fw_cache.busy);
+}
+
+// Waits for the task to be done with the SD Card, while the cache is closed it then stays idle
+static void fw_cache_wait(void)
+{
+    if (!fw_cache.busy)
+        return;
+
+    xSemaphoreTake(fw_cache.busy, portMAX_DELAY);
+    xSemaphoreGive(fw_cache.busy);
+}
+
+// Moves the view and lets the background task prefetch around it. Only entries inside the
+// view and its neighbour pages are kept, the returned ones stay valid until the next call.
+static void fw_cache_set_view(int first)
+{
+    xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+    fw_cache.first = first;
+    for (int i = 0; i < fw_cache.count; i++)
+    {
+        if (fw_cache.entries[i] && (i < first - ITEM_COUNT || i >= first + ITEM_COUNT * 2))
+        {
+            free(fw_cache.entries[i]);
+            fw_cache.entries[i] = NULL;
+        }
+    }
+    xSemaphoreGive(fw_cache.lock);
+
+    xTaskNotifyGive(fw_cache.task);
+}
+
+static const fw_cache_entry_t *fw_cache_get(int index)
+{
+    xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+    fw_cache_entry_t *entry = fw_cache.entries[index];
+    xSemaphoreGive(fw_cache.lock);
+
+    if (!entry)
+    {
+        char fileName[256];
+        odroid_sdcard_dir_name(fw_cache.dir, index, fileName, sizeof(fileName));
+        entry = fw_cache_load(fw_cache.path, fileName);
+
+        xSemaphoreTake(fw_cache.lock, portMAX_DELAY);
+        if (fw_cache.entries[index])
+        {
+            // The background task was faster
+            free(entry);
+            entry = fw_cache.entries[index];
+        }
+        fw_cache.entries[index] = entry;
+        xSemaphoreGive(fw_cache.lock);
+    }
+
+    return entry;
+}
+
+// Firmware is searched in subfolders by a background task. Until it's done, the picker shows
+// the list saved by the previous visit with the new files appended as they're found, then
+// the complete sorted list replaces it and is saved for the next visit. The saved list is
+// windowed like the complete one, its names are read back from the list file, so a new
+// list only takes its place at the start of the next visit.
+#define FW_SCAN_NEW_MAX 512 // Files shown before the scan is done that aren't in the saved list
+static struct
+{
+    SemaphoreHandle_t done;
+    const char *path;
+    odroid_sdcard_dir_t *live;      // Shown while the task runs
+    odroid_sdcard_dir_t *result;    // Complete list, set when the task is done
+    uint32_t *known;                // Sorted hashes of the saved list
+    int knownCount;
+    uint32_t knownSum;
+    int found;
+    uint32_t foundSum;
+    int added;
+    FILE *list;
+    volatile bool finished;
+    volatile bool cancel;
+} fw_scan;
+
+static bool fw_scan_found(const char *name, void *arg)
+{
+    uint32_t hash = odroid_sdcard_name_hash(name);
+
+    if (fw_scan.added < FW_SCAN_NEW_MAX
+        && !bsearch(&hash, fw_scan.known, fw_scan.knownCount, sizeof(uint32_t), &hash_cmp))
+    {
+        odroid_sdcard_dir_add(fw_scan.live, name);
+        fw_scan.added++;
+    }
+
+    if (fw_scan.list)
+        fprintf(fw_scan.list, "%s\n", name);
+
+    fw_scan.found++;
+    fw_scan.foundSum += hash;
+
+    return !fw_scan.cancel;
+}
+
+static void fw_scan_task(void *arg)
+{
+    char newName[160];
+    char tempName[160];
+
+    sprintf(newName, "%s" FW_LIST_NEW_FILE, fw_scan.path);
+    sprintf(tempName, "%s" FW_LIST_TEMP_FILE, fw_scan.path);
+
+    fw_scan.found = 0;
+    fw_scan.foundSum = 0;
+    fw_scan.added = 0;
+
+    // The walk lets the display through between entries
+    odroid_sdcard_bus_take();
+
+    fw_scan.list = fopen(tempName, "w");
+
+    odroid_sdcard_dir_t *dir = odroid_sdcard_dir_open(fw_scan.path, ".fw", FIRMWARE_DEPTH, &fw_scan_found, NULL);
+
+    if (fw_scan.list)
+        fclose(fw_scan.list);
+
+    if (fw_scan.cancel)
+    {
+        odroid_sdcard_dir_close(dir);
+        dir = NULL;
+        remove(tempName);
+    }
+    else if (fw_scan.list && (fw_scan.found != fw_scan.knownCount || fw_scan.foundSum != fw_scan.knownSum))
+    {
+        remove(newName);
+        rename(tempName, newName);
+    }
+    else
+    {
+        remove(tempName);
+    }
+
+    odroid_sdcard_bus_give();
+
+    ESP_LOGI(__func__, "%d files found", fw_scan.found);
+
+    fw_scan.list = NULL;
+    fw_scan.result = dir;
+    fw_scan.finished = true;
+    xSemaphoreGive(fw_scan.done);
+
+    vTaskDelete(NULL);
+}
+
+// Returns the list to show right away, it belongs to the caller
+static odroid_sdcard_dir_t *fw_scan_start(const char *path)
+{
+    char listName[160];
+    char newName[160];
+    struct stat st;
+
+    if (!fw_scan.done)
+        fw_scan.done = xSemaphoreCreateBinary();
+
+    sprintf(listName, "%s" FW_LIST_FILE, path);
+    sprintf(newName, "%s" FW_LIST_NEW_FILE, path);
+    if (stat(newName, &st) == 0)
+    {
+        remove(listName);
+        rename(newName, listName);
+    }
+
+    fw_scan.path = path;
+    fw_scan.result = NULL;
+    fw_scan.finished = false;
+    fw_scan.cancel = false;
+    fw_scan.live = odroid_sdcard_dir_load(path, listName);
+
+    fw_scan.knownCount = odroid_sdcard_dir_count(fw_scan.live);
+    fw_scan.knownSum = 0;
+    fw_scan.known = safe_alloc((fw_scan.knownCount + 1) * sizeof(uint32_t));
+    for (int i = 0; i < fw_scan.knownCount; i++)
+    {
+        fw_scan.known[i] = odroid_sdcard_dir_hash(fw_scan.live, i);
+        fw_scan.knownSum += fw_scan.known[i];
+    }
+    qsort(fw_scan.known, fw_scan.knownCount, sizeof(uint32_t), &hash_cmp);
+
+    xTaskCreatePinnedToCore(&fw_scan_task, "fw_scan_task", 1024 * 6, NULL, 1, NULL, 1);
+
+    return fw_scan.live;
+}
+
+static bool fw_scan_running(void)
+{
+    return fw_scan.live != NULL;
+}
+
+// Returns the complete list once the task is done, then the live list can be closed
+static odroid_sdcard_dir_t *fw_scan_poll(void)
+{
+    if (!fw_scan.live || !fw_scan.finished)
+        return NULL;
+
+    xSemaphoreTake(fw_scan.done, portMAX_DELAY);
+    free(fw_scan.known);
+    fw_scan.known = NULL;
+    fw_scan.live = NULL;
+
+    return fw_scan.result;
+}
+
+static void fw_scan_stop(void)
+{
+    if (!fw_scan.live)
+        return;
+
+    fw_scan.cancel = true;
+    xSemaphoreTake(fw_scan.done, portMAX_DELAY);
+    odroid_sdcard_dir_close(fw_scan.result);
+    free(fw_scan.known);
+    fw_scan.known = NULL;
+    fw_scan.live = NULL;
+}
+
+static char *ui_choose_file(const char *path)
+{
+    char tempstring[128];
+
+    // Check SD card
+    if (sdcardret != ESP_OK)
+    {
+        DisplayPage("Error", "Error");
+        DisplayError("SD CARD ERROR");
+        vTaskDelay(200);
         return NULL;
     }
 
-    char **files = NULL;
+    odroid_sdcard_dir_t *dir = fw_scan_start(path);
     char *result = NULL;
-    int fileCount = odroid_sdcard_files_get(path, ".fw", &files);
+    char fileName[256];
+    int fileCount = odroid_sdcard_dir_count(dir);
     int currentItem = 0;
+    int firstItem = -1;
 
     ESP_LOGI(__func__, "fileCount=%d", fileCount);
 
+    fw_cache_open(path, dir);
+
     while (true)
     {
+        odroid_sdcard_dir_t *complete = fw_scan_poll();
+
+        if (complete)
+        {
+            // Stay on the same file in the complete list
+            uint32_t hash = currentItem < fileCount ? odroid_sdcard_dir_hash(dir, currentItem) : 0;
+
+            fw_cache_close();
+            odroid_sdcard_dir_close(dir);
+
+            dir = complete;
+            fileCount = odroid_sdcard_dir_count(dir);
+            currentItem = 0;
+            firstItem = -1;
+
+            for (int i = 0; i < fileCount; i++)
+            {
+                if (odroid_sdcard_dir_hash(dir, i) == hash)
+                {
+                    currentItem = i;
+                    break;
+                }
+            }
+
+            fw_cache_open(path, dir);
+        }
+        else if (odroid_sdcard_dir_count(dir) != fileCount)
+        {
+            fileCount = odroid_sdcard_dir_count(dir);
+            fw_cache_grow(fileCount);
+        }
+
         int page = (currentItem / ITEM_COUNT) * ITEM_COUNT;
         size_t count, totalFreeSpace;
         odroid_flash_block_t *blocks;
@@ -1017,62 +2252,58 @@ static char *ui_choose_file(const char *path)
 
         sprintf(tempstring, "Free space: %.2fMB (%d block)", (double)totalFreeSpace / 1024 / 1024, count);
 
+        firstItem = ScrollList(firstItem, currentItem);
+
         DisplayPage("Select a file", tempstring);
-        DisplayIndicators(page / ITEM_COUNT + 1, (int)ceil((double)fileCount / ITEM_COUNT));
+        DisplayIndicators(page / ITEM_COUNT + 1, (int)ceil((double)fileCount / ITEM_COUNT), battery_percent());
 
-        for (int line = 0; line < ITEM_COUNT && (page + line) < fileCount; ++line)
-        {
-            char *fileName = files[page + line];
-            bool selected = (page + line) == currentItem;
+        fw_cache_set_view(firstItem);
 
-            sprintf(tempstring, "%s/%s", FIRMWARE_PATH, fileName);
+        for (int line = 0; line < ITEM_COUNT && (firstItem + line) < fileCount; ++line)
+        {
+            odroid_sdcard_dir_name(dir, firstItem + line, fileName, sizeof(fileName));
+            bool selected = (firstItem + line) == currentItem;
 
-            odroid_fw_t *fw = firmware_get_info(tempstring);
-            if (fw) {
+            const fw_cache_entry_t *fw = fw_cache_get(firstItem + line);
+            if (fw->valid) {
                 sprintf(tempstring, "%.2f MB", (float)fw->flashSize / 1024 / 1024);
-                DisplayRow(line, fileName, tempstring, C_GRAY, fw->header.tile, selected);
+                DisplayRow(line, fileName, tempstring, C_GRAY, fw->tile, selected);
             } else {
                 DisplayRow(line, fileName, "Invalid firmware", C_RED, NULL, selected);
             }
-            free(fw);
         }
 
         if (fileCount == 0)
-            DisplayMessage("SD Card Empty");
+            DisplayMessage(fw_scan_running() ? "Searching..." : "SD Card Empty");
 
         UpdateDisplay();
 
-        // Wait for input but refresh display after 1000 ticks if no input
-        int btn = input_wait_for_button_press(1000);
+        // Wait for input but refresh display after 1000 ticks if no input, or as soon as the
+        // scan has something new to show
+        int repeats = 1;
+        int btn;
+        do
+        {
+            btn = input_wait_for_button(fw_scan_running() ? 25 : 1000, &repeats);
+        }
+        while (btn < 0 && fw_scan_running() && !fw_scan.finished && odroid_sdcard_dir_count(dir) == fileCount);
 
         if (fileCount > 0)
         {
-            if (btn == ODROID_INPUT_DOWN)
+            if (btn == ODROID_INPUT_DOWN || btn == ODROID_INPUT_UP || btn == ODROID_INPUT_RIGHT || btn == ODROID_INPUT_LEFT)
             {
-                if (++currentItem >= fileCount) currentItem = 0;
-            }
-            else if (btn == ODROID_INPUT_UP)
-            {
-                if (--currentItem < 0) currentItem = fileCount - 1;
-            }
-            else if (btn == ODROID_INPUT_RIGHT)
-            {
-                if (page + ITEM_COUNT < fileCount) currentItem = page + ITEM_COUNT;
-                else currentItem = 0;
-            }
-            else if (btn == ODROID_INPUT_LEFT)
-            {
-                if (page - ITEM_COUNT >= 0) currentItem = page - ITEM_COUNT;
-                else currentItem = (fileCount - 1) / ITEM_COUNT * ITEM_COUNT;
+                currentItem = ListNavigate(currentItem, fileCount, btn, repeats);
             }
             else if (btn == ODROID_INPUT_A)
             {
-                size_t fullPathLength = strlen(path) + 1 + strlen(files[currentItem]) + 1;
+                odroid_sdcard_dir_name(dir, currentItem, fileName, sizeof(fileName));
+
+                size_t fullPathLength = strlen(path) + 1 + strlen(fileName) + 1;
                 char *fullPath = safe_alloc(fullPathLength);
 
                 strcpy(fullPath, path);
                 strcat(fullPath, "/");
-                strcat(fullPath, files[currentItem]);
+                strcat(fullPath, fileName);
 
                 result = fullPath;
                 break;
@@ -1085,11 +2316,134 @@ static char *ui_choose_file(const char *path)
         }
     }
 
-    odroid_sdcard_files_free(files, fileCount);
+    fw_scan_stop();
+    fw_cache_close();
+    odroid_sdcard_dir_close(dir);
 
     return result;
 }
 
+static bool fw_benchmark_pick(const char *name, void *arg)
+{
+    snprintf(arg, 256, "%s", name);
+    return false;
+}
+
+// Streams up to 2MB of the first firmware file found in 64KB chunks from its first partition's
+// data, like flash_firmware, once through stdio and once through fw_file_t. Returns KB/s.
+static bool fw_benchmark(int *stdioKbps, int *directKbps)
+{
+    const size_t limit = 2 * 1024 * 1024;
+    char name[256] = {0};
+    char fullPath[sizeof(FIRMWARE_PATH) + 256];
+
+    odroid_sdcard_files_walk(FIRMWARE_PATH, ".fw", FIRMWARE_DEPTH, &fw_benchmark_pick, name);
+    if (!name[0])
+        return false;
+
+    sprintf(fullPath, "%s/%s", FIRMWARE_PATH, name);
+
+    odroid_fw_t *fw = firmware_get_info(fullPath);
+    if (!fw)
+        return false;
+
+    size_t start = fw->dataOffset + sizeof(odroid_partition_t);
+    size_t length = start + 4 < fw->fileSize ? RG_MIN(fw->fileSize - 4 - start, limit) : 0;
+    size_t total = 0;
+    free(fw);
+
+    void *dataBuffer = io_alloc(FLASH_BLOCK_SIZE);
+    FILE *fp = fopen(fullPath, "rb");
+    int64_t time = esp_timer_get_time();
+    if (fp && fseek(fp, start, SEEK_SET) == 0)
+    {
+        size_t count;
+        while (total < length && (count = fread(dataBuffer, 1, RG_MIN(length - total, FLASH_BLOCK_SIZE), fp)) > 0)
+            total += count;
+    }
+    time = esp_timer_get_time() - time;
+    *stdioKbps = time > 0 ? (int64_t)total * 1000000 / 1024 / time : 0;
+    if (fp)
+        fclose(fp);
+    free(dataBuffer);
+
+    fw_file_t file;
+    if (!fw_file_open(&file, fullPath, FLASH_BLOCK_SIZE + 512))
+        return false;
+
+    total = 0;
+    time = esp_timer_get_time();
+    fw_file_seek(&file, start);
+    while (total < length)
+    {
+        size_t count = RG_MIN(length - total, FLASH_BLOCK_SIZE);
+        fw_file_next(&file, &count);
+        if (count == 0)
+            break;
+        total += count;
+    }
+    time = esp_timer_get_time() - time;
+    *directKbps = time > 0 ? (int64_t)total * 1000000 / 1024 / time : 0;
+    fw_file_close(&file);
+
+    ESP_LOGI(__func__, "%s: %dKB from offset %d, stdio=%dKB/s fw_file=%dKB/s",
+        name, (int)(total / 1024), (int)start, *stdioKbps, *directKbps);
+
+    return true;
+}
+
+static void ui_sdcard_benchmark(void)
+{
+    odroid_sdcard_bench_t bench;
+    int stdioKbps, directKbps;
+    char tempstring[64];
+
+    DisplayPage("SD Card Benchmark", PROJECT_VER);
+    DisplayMessage("Reading... (be patient)");
+
+    // The raw reads go around FatFs and its lock, nothing else may be using the card. The
+    // picker stops its tasks when it returns, this only makes sure of it.
+    fw_scan_stop();
+    fw_cache_wait();
+
+    if (odroid_sdcard_benchmark(&bench) != ESP_OK)
+    {
+        DisplayError("Benchmark failed!");
+        input_flush();
+        input_wait_for_button_press(50000);
+        return;
+    }
+
+    DisplayPage("SD Card Benchmark", PROJECT_VER);
+
+    sprintf(tempstring, "%.2f MB/s", (double)bench.sequential_kbps / 1024);
+    DisplayRow(0, "Sequential read (32KB)", tempstring, C_GRAY, NULL, false);
+
+    sprintf(tempstring, "%d IOPS, %.2f MB/s", bench.random_iops, (double)bench.random_kbps / 1024);
+    DisplayRow(1, "Random read (4KB)", tempstring, C_GRAY, NULL, false);
+
+    sprintf(tempstring, "%d MHz, %d read errors", bench.clock_khz / 1000, bench.errors);
+    DisplayRow(2, "Bus clock", tempstring, bench.errors ? C_RED : C_GRAY, NULL, false);
+
+    if (fw_benchmark(&stdioKbps, &directKbps))
+        sprintf(tempstring, "%.2f / %.2f MB/s", (double)stdioKbps / 1024, (double)directKbps / 1024);
+    else
+        strcpy(tempstring, "No firmware file");
+    DisplayRow(3, "FW read (stdio/direct)", tempstring, C_GRAY, NULL, false);
+
+    UpdateDisplay();
+
+    // What the display cost since boot, or since the last benchmark
+    lcd_stats_t lcd;
+    ili9341_get_stats(&lcd, true);
+    ESP_LOGI(__func__, "Display: %u frames, %u rows, %uKB in %u transactions (%u windows, %u scrolls), "
+        "%dms busy, %dms on the wire", lcd.frames, lcd.rows, lcd.bytes / 1024, lcd.transactions, lcd.windows,
+        lcd.scrolls, (int)(lcd.busy_us / 1000), (int)(lcd.wire_us / 1000));
+
+    input_flush();
+    input_wait_for_button_press(50000);
+}
+
 static int ui_choose_dialog(dialog_option_t *options, int optionCount, bool cancellable)
 {
     const int border = 3;
@@ -1159,23 +2513,73 @@ static int ui_choose_dialog(dialog_option_t *options, int optionCount, bool canc
     return -1;
 }
 
-static void ui_draw_app_page(int currentItem)
+// The app list page is retained: it remembers what each part of the screen shows and only
+// redraws the parts that changed. Anything else drawing over it must clear `valid`.
+static struct {
+    bool valid;
+    int apps_count;
+    char indicators[32];
+    struct {
+        int item;
+        bool selected;
+    } rows[ITEM_COUNT];
+} app_page;
+
+static void ui_draw_app_page(int firstItem, int currentItem)
 {
+    const char *title = "MULTI-FIRMWARE";
     int page = (currentItem / ITEM_COUNT) * ITEM_COUNT;
+    int totalPages = (int)ceil((double)apps_count / ITEM_COUNT);
+    int battery = battery_percent(); // Sampling it twice could draw a different value than the one compared
+    char indicators[32];
     char tempstring[128];
 
-    DisplayPage("MULTI-FIRMWARE", "[MENU] Menu  |  [A] Boot App");
-    DisplayIndicators(page / ITEM_COUNT + 1, (int)ceil((double)apps_count / ITEM_COUNT));
+    sprintf(indicators, "%d/%d %d", page / ITEM_COUNT + 1, totalPages, battery);
 
-    for (int line = 0; line < ITEM_COUNT && (page + line) < apps_count; ++line)
+    // A row that becomes empty would still show its previous app
+    for (int line = 0; line < ITEM_COUNT; ++line)
     {
-        odroid_app_t *app = &apps[page + line];
-        sprintf(tempstring, "0x%x - 0x%x", app->startOffset, app->endOffset);
-        DisplayRow(line, app->description, tempstring, C_GRAY, app->tile, (page + line) == currentItem);
+        if (app_page.rows[line].item >= 0 && firstItem + line >= apps_count)
+            app_page.valid = false;
+    }
+
+    if (!app_page.valid || app_page.apps_count != apps_count)
+    {
+        DisplayPage(title, "[MENU] Menu  |  [A] Boot App");
+
+        if (apps_count == 0)
+            DisplayMessage("No apps have been flashed yet!");
+
+        for (int line = 0; line < ITEM_COUNT; ++line)
+            app_page.rows[line].item = -1;
+
+        app_page.indicators[0] = 0;
+        app_page.apps_count = apps_count;
+        app_page.valid = true;
+    }
+
+    if (strcmp(indicators, app_page.indicators) != 0)
+    {
+        DisplayTitle(title);
+        DisplayIndicators(page / ITEM_COUNT + 1, totalPages, battery);
+        strcpy(app_page.indicators, indicators);
     }
 
-	if (apps_count == 0)
-        DisplayMessage("No apps have been flashed yet!");
+    for (int line = 0; line < ITEM_COUNT && (firstItem + line) < apps_count; ++line)
+    {
+        int item = firstItem + line;
+        bool selected = item == currentItem;
+
+        if (app_page.rows[line].item == item && app_page.rows[line].selected == selected)
+            continue;
+
+        odroid_app_t *app = &apps[item];
+        sprintf(tempstring, "0x%x - 0x%x", app->startOffset, app->endOffset);
+        DisplayRow(line, app->description, tempstring, C_GRAY, app->tile, selected);
+
+        app_page.rows[line].item = item;
+        app_page.rows[line].selected = selected;
+    }
 
     UpdateDisplay();
 }
@@ -1186,6 +2590,7 @@ static void start_normal(void)
     char tempstring[128];
     int displayOrder = 0;
     int currentItem = 0;
+    int firstItem = -1;
     int queuedBtn = -1;
 
     nvs_flash_init_partition(MFW_NVS_PARTITION);
@@ -1200,34 +2605,20 @@ static void start_normal(void)
 
     while (true)
     {
-        ui_draw_app_page(currentItem);
-
-        int page = (currentItem / ITEM_COUNT) * ITEM_COUNT;
+        firstItem = ScrollList(firstItem, currentItem);
+        ui_draw_app_page(firstItem, currentItem);
 
         // Wait for input but refresh display after 1000 ticks if no input
-        int btn = (queuedBtn != -1) ? queuedBtn : input_wait_for_button_press(1000);
+        int repeats = 1;
+        int btn = (queuedBtn != -1) ? queuedBtn : input_wait_for_button(1000, &repeats);
         queuedBtn = -1;
 
 		if (apps_count > 0)
 		{
-            if (btn == ODROID_INPUT_DOWN)
-	        {
-                if (++currentItem >= apps_count) currentItem = 0;
-	        }
-	        else if (btn == ODROID_INPUT_UP)
-	        {
-                if (--currentItem < 0) currentItem = apps_count - 1;
-	        }
-	        else if (btn == ODROID_INPUT_RIGHT)
-	        {
-                if (page + ITEM_COUNT < apps_count) currentItem = page + ITEM_COUNT;
-                else currentItem = 0;
-	        }
-	        else if (btn == ODROID_INPUT_LEFT)
-	        {
-                if (page - ITEM_COUNT >= 0) currentItem = page - ITEM_COUNT;
-                else currentItem = (apps_count - 1) / ITEM_COUNT * ITEM_COUNT;
-	        }
+            if (btn == ODROID_INPUT_DOWN || btn == ODROID_INPUT_UP || btn == ODROID_INPUT_RIGHT || btn == ODROID_INPUT_LEFT)
+            {
+                currentItem = ListNavigate(currentItem, apps_count, btn, repeats);
+            }
 	        else if (btn == ODROID_INPUT_A)
 	        {
                 DisplayPage("MULTI-FIRMWARE", PROJECT_VER);
@@ -1240,7 +2631,8 @@ static void start_normal(void)
                         displayOrder = (displayOrder & 1);
 
                     sort_app_table(displayOrder);
-                    ui_draw_app_page(currentItem);
+                    app_page.valid = false;
+                    ui_draw_app_page(firstItem, currentItem);
 
                     char descriptions[][16] = {"OFFSET", "INSTALL", "NAME"};
                     char order[][5] = {"ASC", "DESC"};
@@ -1264,14 +2656,15 @@ static void start_normal(void)
                 {2, "Erase selected NVS", apps_count > 0},
                 {3, "Erase all apps", apps_count > 0},
                 {4, "Format SD Card", true},
-                {5, "Restart System", true}
+                {5, "SD Card Benchmark", sdcardret == ESP_OK},
+                {6, "Restart System", true}
             };
 
             odroid_app_t *app = &apps[currentItem];
             char *fileName;
             size_t offset;
 
-            switch (ui_choose_dialog(options, 6, true))
+            switch (ui_choose_dialog(options, 7, true))
             {
                 case 0: // Install from SD Card
                     if ((fileName = ui_choose_file(FIRMWARE_PATH))) {
@@ -1311,6 +2704,7 @@ static void start_normal(void)
                 case 4: // Format SD Card
                     DisplayPage("Format SD Card", PROJECT_VER);
                     DisplayMessage("Press start to begin");
+                    input_flush();
                     if (input_wait_for_button_press(50000) != ODROID_INPUT_START) {
                         break;
                     }
@@ -1328,9 +2722,13 @@ static void start_normal(void)
                     } else {
                         DisplayError("Format failed!");
                     }
+                    input_flush();
                     input_wait_for_button_press(50000);
                     break;
-                case 5: // Restart
+                case 5: // SD Card Benchmark
+                    ui_sdcard_benchmark();
+                    break;
+                case 6: // Restart
                     cleanup_and_restart();
                     break;
             }
@@ -1345,6 +2743,11 @@ static void start_normal(void)
                 boot_application(NULL);
             }
         }
+
+        // Anything but moving in the list has drawn over the page
+        if (btn != -1 && btn != ODROID_INPUT_UP && btn != ODROID_INPUT_DOWN
+            && btn != ODROID_INPUT_LEFT && btn != ODROID_INPUT_RIGHT)
+            app_page.valid = false;
     }
 }
 
@@ -1414,7 +2817,22 @@ void app_main(void)
     ili9341_init();
     input_init();
 
+    fb = FB_IN_PSRAM ? heap_caps_calloc(1, FB_SIZE, MALLOC_CAP_SPIRAM) : NULL;
+    if (!fb)
+        fb = heap_caps_calloc(1, FB_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    if (!fb)
+        abort();
+
+#if FB_FORMAT == FB_FORMAT_INDEXED8
+    fb_palette_init();
+#endif
+
     UG_Init(&gui, pset, SCREEN_WIDTH, SCREEN_HEIGHT);
+    UG_DriverRegister(DRIVER_FILL_FRAME, fb_fill_frame);
+    UG_DriverRegister(DRIVER_DRAW_LINE, fb_draw_line);
+    UG_DriverRegister(DRIVER_FILL_AREA, fb_fill_area);
+    UG_DriverRegister(DRIVER_DRAW_BITS, fb_draw_bits);
+    UG_DriverRegister(DRIVER_BLIT_RGB565, fb_blit);
 
     SET_STATUS_LED(0);
 
@@ -1,3 +1,6 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_log.h>
 #include <esp_vfs_fat.h>
 #include <driver/sdmmc_host.h>
@@ -5,6 +8,8 @@
 #include <sdmmc_cmd.h>
 #include <diskio.h>
 #include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <esp_log.h>
 
 #include <dirent.h>
@@ -22,7 +27,7 @@ extern void ff_diskio_register_sdmmc(unsigned char pdrv, sdmmc_card_t* card);
 #define DECLARE_SDCARD_CONFIG() \
         sdmmc_host_t host_config = SDMMC_HOST_DEFAULT(); \
         host_config.flags = SDMMC_HOST_FLAG_1BIT; \
-        host_config.max_freq_khz = SDMMC_FREQ_HIGHSPEED; \
+        host_config.max_freq_khz = SDMMC_FREQ_DEFAULT; \
         sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT(); \
         slot_config.width = 1;
 #else
@@ -38,14 +43,71 @@ extern void ff_diskio_register_sdmmc(unsigned char pdrv, sdmmc_card_t* card);
         //slot_config.dma_channel = 2;
 #endif
 
+// Clocks tried at mount, fastest first. The last one is the safe one the others are checked
+// against. The SPI pins go through the GPIO matrix, so 40MHz reads fail on many boards.
+#ifdef TARGET_MRGC_G32
+static const int sdcard_clocks[] = {SDMMC_FREQ_HIGHSPEED, SDMMC_FREQ_DEFAULT};
+#else
+static const int sdcard_clocks[] = {SDMMC_FREQ_HIGHSPEED, SDMMC_FREQ_26M, SDMMC_FREQ_DEFAULT};
+#endif
+#define SDCARD_CLOCKS (sizeof(sdcard_clocks) / sizeof(sdcard_clocks[0]))
+#define SDCARD_CHECK_SECTORS 32
+#define SDCARD_CHECK_PASSES 4
+
+static sdmmc_card_t* sdcard;
+static int sdcard_clock;
 
-inline static void swap(char** a, char** b)
+// On the ODROID-GO the card and the display share HSPI, and the SD driver keeps the card
+// selected across several transactions. Tasks that use the card in the background hold the
+// bus, the display takes it around each frame. Directory walks let a waiting frame through
+// between entries. The MRGC-G32's card is on the SDMMC host, it doesn't need any of this.
+#ifndef TARGET_MRGC_G32
+static SemaphoreHandle_t bus_lock;
+static volatile int bus_waiting;
+static portMUX_TYPE bus_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+void odroid_sdcard_bus_take(void)
 {
-    char* t = *a;
-    *a = *b;
-    *b = t;
+#ifndef TARGET_MRGC_G32
+    // The display takes it first, before any background task exists
+    if (!bus_lock)
+        bus_lock = xSemaphoreCreateMutex();
+
+    portENTER_CRITICAL(&bus_mux);
+    bus_waiting++;
+    portEXIT_CRITICAL(&bus_mux);
+
+    xSemaphoreTake(bus_lock, portMAX_DELAY);
+
+    portENTER_CRITICAL(&bus_mux);
+    bus_waiting--;
+    portEXIT_CRITICAL(&bus_mux);
+#endif
+}
+
+void odroid_sdcard_bus_give(void)
+{
+#ifndef TARGET_MRGC_G32
+    xSemaphoreGive(bus_lock);
+#endif
 }
 
+// Called between two accesses of a long operation, the task may or may not hold the bus
+static void bus_yield(void)
+{
+#ifndef TARGET_MRGC_G32
+    if (bus_waiting > 0 && xSemaphoreGetMutexHolder(bus_lock) == xTaskGetCurrentTaskHandle())
+    {
+        xSemaphoreGive(bus_lock);
+        while (bus_waiting > 0)
+            vTaskDelay(1);
+        xSemaphoreTake(bus_lock, portMAX_DELAY);
+    }
+#endif
+}
+
+
 static int strcicmp(char const *a, char const *b)
 {
     for (;; a++, b++)
@@ -55,102 +117,709 @@ static int strcicmp(char const *a, char const *b)
     }
 }
 
-static int partition (char* arr[], int low, int high)
+// Bottom-up merge sort: O(n log n) whatever the initial order (FAT directories are often
+// nearly sorted, which was quicksort's worst case) and no recursion.
+static void sort_files(char** files, int count)
 {
-    char* pivot = arr[high];
-    int i = (low - 1);
+    char** temp = malloc(count * sizeof(char*));
+    char** src = files;
+    char** dst = temp;
 
-    for (int j = low; j <= high- 1; j++)
+    if (count < 2 || !temp)
     {
-        if (strcicmp(arr[j], pivot) < 0)
+        free(temp);
+        return;
+    }
+
+    for (int width = 1; width < count; width *= 2)
+    {
+        for (int left = 0; left < count; left += width * 2)
         {
-            i++;
-            swap(&arr[i], &arr[j]);
+            int mid = left + width < count ? left + width : count;
+            int right = left + width * 2 < count ? left + width * 2 : count;
+            int i = left, j = mid, k = left;
+
+            while (i < mid && j < right)
+                dst[k++] = strcicmp(src[j], src[i]) < 0 ? src[j++] : src[i++];
+            while (i < mid)
+                dst[k++] = src[i++];
+            while (j < right)
+                dst[k++] = src[j++];
         }
+
+        char** t = src;
+        src = dst;
+        dst = t;
     }
-    swap(&arr[i + 1], &arr[high]);
-    return (i + 1);
+
+    if (src != files)
+        memcpy(files, src, count * sizeof(char*));
+
+    free(temp);
 }
 
-static void quick_sort(char* arr[], int low, int high)
+// Names are packed one after the other in a growing buffer while scanning, then the list
+// is built in a single allocation: the pointers followed by the names they point to.
+typedef struct
 {
-    if (low < high)
+    char* names;
+    size_t length;
+    size_t capacity;
+    int count;
+} files_arena_t;
+
+static bool files_arena_add(const char* name, void* arg)
+{
+    files_arena_t* arena = arg;
+    size_t len = strlen(name) + 1;
+
+    if (arena->length + len > arena->capacity)
     {
-        int pi = partition(arr, low, high);
+        size_t capacity = arena->capacity ? arena->capacity * 2 : 4096;
+        while (capacity < arena->length + len)
+            capacity *= 2;
 
-        quick_sort(arr, low, pi - 1);
-        quick_sort(arr, pi + 1, high);
+        char* names = realloc(arena->names, capacity);
+        if (!names) abort();
+
+        arena->names = names;
+        arena->capacity = capacity;
     }
+
+    memcpy(arena->names + arena->length, name, len);
+    arena->length += len;
+    arena->count++;
+    return true;
 }
 
-static void sort_files(char** files, int count)
+// Folders are visited breadth first and one at a time, so only one directory is open at once.
+// Names are given relative to `path` ("folder/name.fw"), `depth` is how many levels of
+// subfolders are searched.
+int odroid_sdcard_files_walk(const char* path, const char* extension, int depth, odroid_sdcard_scan_cb_t callback, void* arg)
+{
+    int extensionLength = strlen(extension);
+    files_arena_t pending = {0};    // Folders left to visit
+    size_t next = 0;
+    int count = 0;
+    bool stop = false;
+    char folder[256];
+    char name[256];
+    char fullPath[384];
+
+    files_arena_add("", &pending);
+
+    while (next < pending.length && !stop)
+    {
+        strcpy(folder, pending.names + next);
+        next += strlen(folder) + 1;
+
+        int level = folder[0] ? 1 : 0;
+        for (char* c = folder; *c; c++)
+            level += *c == '/';
+
+        snprintf(fullPath, sizeof(fullPath), "%s%s%s", path, folder[0] ? "/" : "", folder);
+
+        DIR *dir = opendir(fullPath);
+        if (dir == NULL)
+        {
+            ESP_LOGE(__func__, "opendir failed: %s", fullPath);
+            if (level == 0)
+            {
+                free(pending.names);
+                return -1;
+            }
+            continue;
+        }
+
+        struct dirent *entry;
+        while (!stop && (entry = readdir(dir)))
+        {
+            bus_yield();
+
+            size_t len = strlen(entry->d_name);
+
+            if (entry->d_name[0] == '.')
+                continue;
+
+            if (snprintf(name, sizeof(name), "%s%s%s", folder, folder[0] ? "/" : "", entry->d_name) >= sizeof(name))
+                continue;
+
+            if (entry->d_type == DT_DIR)
+            {
+                if (level < depth)
+                    files_arena_add(name, &pending);
+                continue;
+            }
+
+            if (len < extensionLength)
+                continue;
+
+            if (strcasecmp(extension, &entry->d_name[len - extensionLength]) != 0)
+                continue;
+
+            count++;
+
+            stop = !callback(name, arg);
+        }
+
+        closedir(dir);
+    }
+
+    free(pending.names);
+
+    return count;
+}
+
+uint32_t odroid_sdcard_name_hash(const char* name)
+{
+    uint32_t hash = 0x811C9DC5;
+    while (*name)
+        hash = (hash ^ (uint8_t)*name++) * 0x01000193;
+    return hash;
+}
+
+// Directory listing for folders of any size. Up to DIR_NAMES_MAX files the sorted names are
+// kept, past that each file only costs a small entry: its position in the walk, a hash of
+// its name and a sort key made of its first characters. The names of a window of DIR_WINDOW
+// entries around the last one requested are read back from the directory, or from the list
+// file the listing was loaded from.
+#define DIR_NAMES_MAX 512
+#define DIR_WINDOW 64
+#define DIR_KEY_LENGTH 12
+#define DIR_NAME_LENGTH 256
+
+typedef struct
+{
+    uint32_t position;  // Among the matching files, in walk order
+    uint32_t hash;
+    char key[DIR_KEY_LENGTH];
+} dir_entry_t;
+
+struct odroid_sdcard_dir
+{
+    SemaphoreHandle_t lock;
+    char path[128];
+    char extension[16];
+    int depth;
+    int count;
+    files_arena_t names;    // Small listings: the names...
+    uint32_t* offsets;      // ...and where each one starts, in sorted order
+    int offsetsCapacity;
+    dir_entry_t* entries;   // Large listings
+    int capacity;
+    odroid_sdcard_scan_cb_t progress;
+    void* progressArg;
+    int windowFirst;
+    int windowCount;
+    char (*window)[DIR_NAME_LENGTH];
+    char list[160];         // Loaded from a list file, one name per line
+    int listed;             // Files in the list, the names of the ones added after it are kept
+};
+
+static void dir_names_add(odroid_sdcard_dir_t* dir, const char* name)
 {
-    if (count > 1)
+    if (dir->names.count == dir->offsetsCapacity)
     {
-        quick_sort(files, 0, count - 1);
+        dir->offsetsCapacity = dir->offsetsCapacity ? dir->offsetsCapacity * 2 : 64;
+        dir->offsets = realloc(dir->offsets, dir->offsetsCapacity * sizeof(uint32_t));
+        if (!dir->offsets) abort();
     }
+
+    dir->offsets[dir->names.count] = dir->names.length;
+    files_arena_add(name, &dir->names);
 }
 
+static void dir_names_free(odroid_sdcard_dir_t* dir)
+{
+    free(dir->names.names);
+    free(dir->offsets);
+    memset(&dir->names, 0, sizeof(dir->names));
+    dir->offsets = NULL;
+    dir->offsetsCapacity = 0;
+}
 
-int odroid_sdcard_files_get(const char* path, const char* extension, char*** filesOut)
+static void dir_names_sort(odroid_sdcard_dir_t* dir)
 {
-    const int MAX_FILES = 1024;
+    char** files = malloc((dir->names.count + 1) * sizeof(char*));
+    if (!files) abort();
+
+    for (int i = 0; i < dir->names.count; i++)
+        files[i] = dir->names.names + dir->offsets[i];
+
+    sort_files(files, dir->names.count);
+
+    for (int i = 0; i < dir->names.count; i++)
+        dir->offsets[i] = files[i] - dir->names.names;
+
+    free(files);
+}
+
+static void dir_key(char* key, const char* name)
+{
+    for (int i = 0; i < DIR_KEY_LENGTH; i++)
+        key[i] = *name ? tolower((int)*name++) : 0;
+}
+
+static void dir_entry_add(odroid_sdcard_dir_t* dir, const char* name)
+{
+    if (dir->count == dir->capacity)
+    {
+        dir->capacity = dir->capacity ? dir->capacity * 2 : 256;
+        dir_entry_t* entries = heap_caps_realloc(dir->entries, dir->capacity * sizeof(dir_entry_t), MALLOC_CAP_SPIRAM);
+        if (!entries)
+            entries = realloc(dir->entries, dir->capacity * sizeof(dir_entry_t));
+        if (!entries) abort();
+        dir->entries = entries;
+    }
+
+    dir_entry_t* entry = &dir->entries[dir->count];
+    entry->position = dir->count++;
+    entry->hash = odroid_sdcard_name_hash(name);
+    dir_key(entry->key, name);
+}
 
+static bool dir_scan_add(const char* name, void* arg)
+{
+    odroid_sdcard_dir_t* dir = arg;
+
+    dir_entry_add(dir, name);
+
+    // The names are only kept while the listing is small
+    if (dir->count <= DIR_NAMES_MAX)
+        dir_names_add(dir, name);
+    else if (dir->offsets)
+        dir_names_free(dir);
+
+    return !dir->progress || dir->progress(name, dir->progressArg);
+}
+
+static int dir_entry_cmp(const void* a, const void* b)
+{
+    const dir_entry_t* ea = a;
+    const dir_entry_t* eb = b;
+    int d = memcmp(ea->key, eb->key, DIR_KEY_LENGTH);
+    return d ? d : (int)ea->position - (int)eb->position;
+}
+
+static odroid_sdcard_dir_t* dir_alloc(const char* path, const char* extension, int depth)
+{
+    odroid_sdcard_dir_t* dir = calloc(1, sizeof(odroid_sdcard_dir_t));
+    if (!dir) abort();
+
+    strncpy(dir->path, path, sizeof(dir->path) - 1);
+    strncpy(dir->extension, extension, sizeof(dir->extension) - 1);
+    dir->depth = depth;
+    dir->lock = xSemaphoreCreateMutex();
+
+    return dir;
+}
+
+// Reads one name per line, until `callback` returns false
+static void dir_list_read(const char* fileName, odroid_sdcard_scan_cb_t callback, void* arg)
+{
+    char line[DIR_NAME_LENGTH + 2];
+
+    FILE* fp = fopen(fileName, "r");
+    if (!fp)
+        return;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        bus_yield();
+        line[strcspn(line, "\r\n")] = 0;
+        if (line[0] && !callback(line, arg))
+            break;
+    }
+
+    fclose(fp);
+}
+
+// Reads the names of the files in position order, from the list file or the directory
+static void dir_read_names(odroid_sdcard_dir_t* dir, odroid_sdcard_scan_cb_t callback, void* arg)
+{
+    if (dir->list[0])
+        dir_list_read(dir->list, callback, arg);
+    else
+        odroid_sdcard_files_walk(dir->path, dir->extension, dir->depth, callback, arg);
+}
+
+// Files whose keys are equal
+typedef struct
+{
+    uint32_t position;
+    uint32_t hash;
+    int run;        // Index of the first entry of the run
+    char key[DIR_KEY_LENGTH];
+} dir_tie_t;
+
+typedef struct
+{
+    dir_tie_t* ties;
+    int count;
+    int next;
+    uint32_t position;
+    size_t offset;
+} dir_tie_fill_t;
+
+static bool dir_tie_add(const char* name, void* arg)
+{
+    dir_tie_fill_t* fill = arg;
+
+    if (fill->ties[fill->next].position == fill->position)
+    {
+        size_t len = strlen(name);
+        dir_key(fill->ties[fill->next].key, len > fill->offset ? name + fill->offset : "");
+        fill->next++;
+    }
+
+    fill->position++;
+    return fill->next < fill->count;
+}
+
+static int dir_tie_position_cmp(const void* a, const void* b)
+{
+    return (int)((const dir_tie_t*)a)->position - (int)((const dir_tie_t*)b)->position;
+}
+
+static int dir_tie_cmp(const void* a, const void* b)
+{
+    const dir_tie_t* ta = a;
+    const dir_tie_t* tb = b;
+    if (ta->run != tb->run)
+        return ta->run - tb->run;
+    int d = memcmp(ta->key, tb->key, DIR_KEY_LENGTH);
+    return d ? d : (int)ta->position - (int)tb->position;
+}
+
+// Only the first DIR_KEY_LENGTH characters are kept for sorting. Runs of files that share
+// them are ordered by reading the next DIR_KEY_LENGTH characters of their names, in one pass
+// over the directory, until no two files still collide. Most listings need one pass or none.
+static void dir_sort_ties(odroid_sdcard_dir_t* dir)
+{
+    dir_tie_t* ties = NULL;
     int count = 0;
-    char** result = (char**)malloc(MAX_FILES * sizeof(void*));
-    if (!result) abort();
 
+    for (int i = 0; i < dir->count - 1; i++)
+    {
+        int end = i + 1;
+        while (end < dir->count && dir->entries[i].key[DIR_KEY_LENGTH - 1]
+               && memcmp(dir->entries[i].key, dir->entries[end].key, DIR_KEY_LENGTH) == 0)
+            end++;
+
+        if (end - i > 1)
+        {
+            if (!ties)
+            {
+                ties = heap_caps_malloc(dir->count * sizeof(dir_tie_t), MALLOC_CAP_SPIRAM);
+                if (!ties)
+                    ties = malloc(dir->count * sizeof(dir_tie_t));
+                if (!ties) abort();
+            }
+
+            for (int j = i; j < end; j++)
+                ties[count++] = (dir_tie_t){dir->entries[j].position, dir->entries[j].hash, i};
+        }
 
-    DIR *dir = opendir(path);
-    if( dir == NULL )
+        i = end - 1;
+    }
+
+    for (size_t offset = DIR_KEY_LENGTH; count > 0 && offset < DIR_NAME_LENGTH; offset += DIR_KEY_LENGTH)
     {
-        ESP_LOGE(__func__, "opendir failed.");
-        return 0;
+        ESP_LOGI(__func__, "%d files share a sort key, reading %d more characters", count, DIR_KEY_LENGTH);
+
+        qsort(ties, count, sizeof(dir_tie_t), &dir_tie_position_cmp);
+
+        dir_tie_fill_t fill = {ties, count, 0, 0, offset};
+        dir_read_names(dir, &dir_tie_add, &fill);
+
+        // A file that wasn't found again sorts first in its run
+        for (int i = fill.next; i < count; i++)
+            memset(ties[i].key, 0, DIR_KEY_LENGTH);
+
+        qsort(ties, count, sizeof(dir_tie_t), &dir_tie_cmp);
+
+        int left = 0;
+        for (int i = 0; i < count; )
+        {
+            int run = ties[i].run;
+            int end = i;
+
+            // The run keeps its first key, only the order of its files changes
+            for (int k = 0; end < count && ties[end].run == run; end++, k++)
+            {
+                dir->entries[run + k].position = ties[end].position;
+                dir->entries[run + k].hash = ties[end].hash;
+            }
+
+            // Files still colliding form smaller runs for the next pass
+            for (int j = i; j < end; )
+            {
+                int next = j + 1;
+                while (next < end && ties[j].key[DIR_KEY_LENGTH - 1]
+                       && memcmp(ties[j].key, ties[next].key, DIR_KEY_LENGTH) == 0)
+                    next++;
+
+                for (int k = j; next - j > 1 && k < next; k++)
+                {
+                    ties[left] = ties[k];
+                    ties[left++].run = run + (j - i);
+                }
+                j = next;
+            }
+
+            i = end;
+        }
+
+        count = left;
     }
 
-    int extensionLength = strlen(extension);
-    if (extensionLength < 1) abort();
+    free(ties);
+}
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)))
+static void dir_finish(odroid_sdcard_dir_t* dir)
+{
+    if (dir->count <= DIR_NAMES_MAX)
     {
-        size_t len = strlen(entry->d_name);
+        free(dir->entries);
+        dir->entries = NULL;
+        dir->capacity = 0;
+        dir_names_sort(dir);
+    }
+    else
+    {
+        qsort(dir->entries, dir->count, sizeof(dir_entry_t), &dir_entry_cmp);
+        dir_sort_ties(dir);
+    }
 
-        if (len < extensionLength)
-            continue;
+    ESP_LOGI(__func__, "%d files, %s", dir->count, dir->entries ? "windowed" : "all names loaded");
+}
 
-        if (entry->d_name[0] == '.')
-            continue;
+odroid_sdcard_dir_t* odroid_sdcard_dir_open(const char* path, const char* extension, int depth,
+                                            odroid_sdcard_scan_cb_t progress, void* arg)
+{
+    odroid_sdcard_dir_t* dir = dir_alloc(path, extension, depth);
 
-        if (strcasecmp(extension, &entry->d_name[len - extensionLength]) != 0)
-            continue;
+    dir->progress = progress;
+    dir->progressArg = arg;
+
+    odroid_sdcard_files_walk(path, extension, depth, &dir_scan_add, dir);
+
+    dir->progress = NULL;
+
+    dir_finish(dir);
+
+    return dir;
+}
 
-        if (!(result[count++] = strdup(entry->d_name)))
-            abort();
+odroid_sdcard_dir_t* odroid_sdcard_dir_load(const char* path, const char* listFile)
+{
+    odroid_sdcard_dir_t* dir = dir_alloc(path, "", 0);
+
+    strncpy(dir->list, listFile, sizeof(dir->list) - 1);
+    dir_list_read(dir->list, &dir_scan_add, dir);
+    dir_finish(dir);
+    dir->listed = dir->count;
 
-        if (count >= MAX_FILES)
+    return dir;
+}
+
+void odroid_sdcard_dir_add(odroid_sdcard_dir_t* dir, const char* name)
+{
+    xSemaphoreTake(dir->lock, portMAX_DELAY);
+    if (dir->entries)
+        dir_entry_add(dir, name);
+    else
+        dir->count++;
+    dir_names_add(dir, name);
+    xSemaphoreGive(dir->lock);
+}
+
+void odroid_sdcard_dir_close(odroid_sdcard_dir_t* dir)
+{
+    if (!dir)
+        return;
+
+    dir_names_free(dir);
+    vSemaphoreDelete(dir->lock);
+    free(dir->entries);
+    free(dir->window);
+    free(dir);
+}
+
+int odroid_sdcard_dir_count(odroid_sdcard_dir_t* dir)
+{
+    return dir ? dir->count : 0;
+}
+
+uint32_t odroid_sdcard_dir_hash(odroid_sdcard_dir_t* dir, int index)
+{
+    uint32_t hash;
+
+    // Adding files may move the entries too
+    xSemaphoreTake(dir->lock, portMAX_DELAY);
+    if (dir->entries)
+        hash = dir->entries[index].hash;
+    else
+        hash = odroid_sdcard_name_hash(dir->names.names + dir->offsets[index]);
+    xSemaphoreGive(dir->lock);
+
+    return hash;
+}
+
+typedef struct
+{
+    odroid_sdcard_dir_t* dir;
+    int* slots;     // Window slots ordered by directory position
+    int next;
+    int position;
+} dir_window_fill_t;
+
+static bool dir_window_add(const char* name, void* arg)
+{
+    dir_window_fill_t* fill = arg;
+    odroid_sdcard_dir_t* dir = fill->dir;
+
+    while (fill->next < dir->windowCount)
+    {
+        int slot = fill->slots[fill->next];
+        uint32_t position = dir->entries[dir->windowFirst + slot].position;
+
+        if (position > fill->position)
             break;
+        if (position == fill->position)
+            strncpy(dir->window[slot], name, DIR_NAME_LENGTH - 1);
+        fill->next++;
     }
 
-    closedir(dir);
+    fill->position++;
+    return fill->next < dir->windowCount;
+}
 
-    sort_files(result, count);
+// Reads the names of the window around `index` in a single pass over the directory
+static void dir_window_load(odroid_sdcard_dir_t* dir, int index)
+{
+    int first = index - DIR_WINDOW / 4;
+    if (first + DIR_WINDOW > dir->count) first = dir->count - DIR_WINDOW;
+    if (first < 0) first = 0;
 
-    *filesOut = result;
-    return count;
+    if (!dir->window)
+    {
+        dir->window = heap_caps_malloc(DIR_WINDOW * DIR_NAME_LENGTH, MALLOC_CAP_SPIRAM);
+        if (!dir->window)
+            dir->window = malloc(DIR_WINDOW * DIR_NAME_LENGTH);
+        if (!dir->window) abort();
+    }
+
+    dir->windowFirst = first;
+    dir->windowCount = dir->count - first < DIR_WINDOW ? dir->count - first : DIR_WINDOW;
+    memset(dir->window, 0, DIR_WINDOW * DIR_NAME_LENGTH);
+
+    int slots[DIR_WINDOW];
+    for (int i = 0; i < dir->windowCount; i++)
+        slots[i] = i;
+
+    // Insertion sort by position, the window is small
+    for (int i = 1; i < dir->windowCount; i++)
+    {
+        for (int j = i; j > 0 && dir->entries[first + slots[j]].position < dir->entries[first + slots[j - 1]].position; j--)
+        {
+            int t = slots[j];
+            slots[j] = slots[j - 1];
+            slots[j - 1] = t;
+        }
+    }
+
+    dir_window_fill_t fill = {dir, slots, 0, 0};
+    dir_read_names(dir, &dir_window_add, &fill);
+}
+
+bool odroid_sdcard_dir_name(odroid_sdcard_dir_t* dir, int index, char* name, size_t size)
+{
+    if (!dir || index < 0 || index >= dir->count || size < 1)
+        return false;
+
+    xSemaphoreTake(dir->lock, portMAX_DELAY);
+
+    if (!dir->entries)
+    {
+        strncpy(name, dir->names.names + dir->offsets[index], size - 1);
+    }
+    else if (dir->list[0] && dir->entries[index].position >= dir->listed)
+    {
+        strncpy(name, dir->names.names + dir->offsets[dir->entries[index].position - dir->listed], size - 1);
+    }
+    else
+    {
+        if (!dir->window || index < dir->windowFirst || index >= dir->windowFirst + dir->windowCount)
+            dir_window_load(dir, index);
+        strncpy(name, dir->window[index - dir->windowFirst], size - 1);
+    }
+    name[size - 1] = 0;
+
+    xSemaphoreGive(dir->lock);
+
+    return name[0] != 0;
 }
 
-void odroid_sdcard_files_free(char** files, int count)
+// The first sectors of the first partition: boot sector, then the FAT. Sector 0 is mostly empty.
+static size_t sdcard_check_start(uint8_t* buffer)
 {
-    for (int i = 0; i < count; ++i)
+    if (sdmmc_read_sectors(sdcard, buffer, 0, 1) != ESP_OK || buffer[510] != 0x55 || buffer[511] != 0xAA)
+        return 0;
+
+    size_t start = buffer[454] | buffer[455] << 8 | buffer[456] << 16 | (size_t)buffer[457] << 24;
+
+    return start + SDCARD_CHECK_SECTORS <= sdcard->csd.capacity ? start : 0;
+}
+
+// Returns the fastest clock that reads back the same data as the safe one, the card was
+// mounted with the fastest one so it's already in high speed mode if it supports it.
+static int sdcard_pick_clock(const sdmmc_host_t* host)
+{
+    size_t size = SDCARD_CHECK_SECTORS * 512;
+    uint8_t* reference = heap_caps_malloc(size, MALLOC_CAP_DMA);
+    uint8_t* buffer = heap_caps_malloc(size, MALLOC_CAP_DMA);
+    int clock = sdcard_clocks[SDCARD_CLOCKS - 1];
+    size_t start;
+
+    if (!reference || !buffer)
+        goto _cleanup;
+
+    host->set_card_clk(host->slot, clock);
+
+    start = sdcard_check_start(reference);
+    if (sdmmc_read_sectors(sdcard, reference, start, SDCARD_CHECK_SECTORS) != ESP_OK)
+        goto _cleanup;
+
+    for (int i = 0; i < SDCARD_CLOCKS - 1; i++)
     {
-        free(files[i]);
+        bool ok = sdcard_clocks[i] <= sdcard->max_freq_khz;
+
+        host->set_card_clk(host->slot, sdcard_clocks[i]);
+
+        for (int pass = 0; pass < SDCARD_CHECK_PASSES && ok; pass++)
+        {
+            ok = sdmmc_read_sectors(sdcard, buffer, start, SDCARD_CHECK_SECTORS) == ESP_OK
+                 && memcmp(buffer, reference, size) == 0;
+        }
+
+        if (ok)
+        {
+            clock = sdcard_clocks[i];
+            break;
+        }
+
+        ESP_LOGW(__func__, "%dkHz failed the read-back check", sdcard_clocks[i]);
     }
 
-    free(files);
+_cleanup:
+    free(reference);
+    free(buffer);
+
+    return clock;
 }
 
-esp_err_t odroid_sdcard_open(void)
+static esp_err_t sdcard_mount(int clock)
 {
     DECLARE_SDCARD_CONFIG();
 
@@ -159,14 +828,56 @@ esp_err_t odroid_sdcard_open(void)
         .max_files = 5,
     };
 
-    esp_err_t ret = esp_vfs_fat_sdmmc_mount(SDCARD_BASE_PATH, &host_config, &slot_config, &mount_config, NULL);
+    host_config.max_freq_khz = clock;
+
+    esp_err_t ret = esp_vfs_fat_sdmmc_mount(SDCARD_BASE_PATH, &host_config, &slot_config, &mount_config, &sdcard);
+
+    if (ret == ESP_OK)
+    {
+        int best = sdcard_pick_clock(&host_config);
+
+        if (best != clock)
+        {
+            // A failed read can leave the card mid-transfer, start it over at the right clock
+            esp_vfs_fat_sdmmc_unmount();
+            host_config.max_freq_khz = best;
+            ret = esp_vfs_fat_sdmmc_mount(SDCARD_BASE_PATH, &host_config, &slot_config, &mount_config, &sdcard);
+
+            // The check read the card fine at the slowest clock, go back to it
+            if (ret != ESP_OK && best != sdcard_clocks[SDCARD_CLOCKS - 1])
+            {
+                ESP_LOGW(__func__, "Remount at %dkHz failed (%d), using %dkHz", best, ret, sdcard_clocks[SDCARD_CLOCKS - 1]);
+                best = sdcard_clocks[SDCARD_CLOCKS - 1];
+                host_config.max_freq_khz = best;
+                ret = esp_vfs_fat_sdmmc_mount(SDCARD_BASE_PATH, &host_config, &slot_config, &mount_config, &sdcard);
+            }
+        }
+
+        sdcard_clock = best;
+    }
+
+    return ret;
+}
+
+esp_err_t odroid_sdcard_open(void)
+{
+    // Try the fastest clock first, the card may not even initialize at it
+    esp_err_t ret = sdcard_mount(sdcard_clocks[0]);
+
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGW(__func__, "Mount at %dkHz failed (%d), retrying", sdcard_clocks[0], ret);
+        ret = sdcard_mount(sdcard_clocks[SDCARD_CLOCKS - 1]);
+    }
 
     if (ret == ESP_OK || ret == ESP_ERR_INVALID_STATE)
     {
+        ESP_LOGI(__func__, "Card clock: %dkHz", sdcard_clock);
         ret = ESP_OK;
     }
     else
     {
+        sdcard = NULL;
         ESP_LOGE(__func__, "esp_vfs_fat_sdmmc_mount failed (%d)", ret);
     }
 
@@ -177,6 +888,8 @@ esp_err_t odroid_sdcard_close(void)
 {
     esp_err_t ret = esp_vfs_fat_sdmmc_unmount();
 
+    sdcard = NULL;
+
     if (ret != ESP_OK)
     {
         ESP_LOGE(__func__, "esp_vfs_fat_sdmmc_unmount failed (%d)", ret);
@@ -185,6 +898,56 @@ esp_err_t odroid_sdcard_close(void)
     return ret;
 }
 
+// Raw sector reads, below the filesystem: sequential from the start of the first partition,
+// then 4KB reads at random places on the whole card.
+esp_err_t odroid_sdcard_benchmark(odroid_sdcard_bench_t* out)
+{
+    const size_t chunkSectors = 64;
+    const size_t sequentialSectors = 4 * 1024 * 1024 / 512;
+    const int randomReads = 256;
+
+    if (!sdcard)
+        return ESP_ERR_INVALID_STATE;
+
+    uint8_t* buffer = heap_caps_malloc(chunkSectors * 512, MALLOC_CAP_DMA);
+    if (!buffer)
+        return ESP_ERR_NO_MEM;
+
+    memset(out, 0, sizeof(*out));
+    out->clock_khz = sdcard_clock;
+
+    size_t capacity = sdcard->csd.capacity;
+    size_t start = sdcard_check_start(buffer);
+    size_t length = start + sequentialSectors <= capacity ? sequentialSectors : capacity - start;
+
+    int64_t time = esp_timer_get_time();
+    for (size_t sector = 0; sector + chunkSectors <= length; sector += chunkSectors)
+    {
+        if (sdmmc_read_sectors(sdcard, buffer, start + sector, chunkSectors) != ESP_OK)
+            out->errors++;
+    }
+    time = esp_timer_get_time() - time;
+    out->sequential_kbps = time > 0 ? (int64_t)length * 512 * 1000000 / 1024 / time : 0;
+
+    time = esp_timer_get_time();
+    for (int i = 0; i < randomReads; i++)
+    {
+        size_t sector = (esp_random() % (capacity / 8)) * 8;
+        if (sdmmc_read_sectors(sdcard, buffer, sector, 8) != ESP_OK)
+            out->errors++;
+    }
+    time = esp_timer_get_time() - time;
+    out->random_iops = time > 0 ? (int64_t)randomReads * 1000000 / time : 0;
+    out->random_kbps = out->random_iops * 4;
+
+    free(buffer);
+
+    ESP_LOGI(__func__, "clock=%dkHz sequential=%dKB/s random=%d IOPS (%dKB/s) errors=%d",
+        out->clock_khz, out->sequential_kbps, out->random_iops, out->random_kbps, out->errors);
+
+    return ESP_OK;
+}
+
 esp_err_t odroid_sdcard_format(int fs_type)
 {
     esp_err_t err = ESP_FAIL;
@@ -196,6 +959,10 @@ esp_err_t odroid_sdcard_format(int fs_type)
 
     DECLARE_SDCARD_CONFIG();
 
+    // The clock the card was mounted at passed the read-back check in sdcard_pick_clock
+    if (sdcard_clock)
+        host_config.max_freq_khz = sdcard_clock;
+
     if (buffer == NULL) {
         return false;
     }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "esp_err.h"
 
 #define SDCARD_BASE_PATH "/sd"
@@ -8,5 +11,40 @@ esp_err_t odroid_sdcard_open(void);
 esp_err_t odroid_sdcard_close(void);
 esp_err_t odroid_sdcard_format(int fs_type);
 
-int odroid_sdcard_files_get(const char* path, const char* extension, char*** filesOut);
-void odroid_sdcard_files_free(char** files, int count);
+// The ODROID-GO's card shares its SPI bus with the display, background tasks hold it while
+// they use the card and the display around each frame
+void odroid_sdcard_bus_take(void);
+void odroid_sdcard_bus_give(void);
+
+typedef struct
+{
+    int clock_khz;
+    int sequential_kbps;
+    int random_iops;    // 4KB reads
+    int random_kbps;
+    int errors;
+} odroid_sdcard_bench_t;
+
+esp_err_t odroid_sdcard_benchmark(odroid_sdcard_bench_t* out);
+
+// Called for every matching file as the directory is read, return false to stop the scan
+typedef bool (*odroid_sdcard_scan_cb_t)(const char* name, void* arg);
+
+int odroid_sdcard_files_walk(const char* path, const char* extension, int depth, odroid_sdcard_scan_cb_t callback, void* arg);
+uint32_t odroid_sdcard_name_hash(const char* name);
+
+// Sorted listing that only keeps the names of a window in memory when it's very large.
+// `progress` is called for every file found while the listing is built.
+typedef struct odroid_sdcard_dir odroid_sdcard_dir_t;
+
+odroid_sdcard_dir_t* odroid_sdcard_dir_open(const char* path, const char* extension, int depth,
+                                            odroid_sdcard_scan_cb_t progress, void* arg);
+// Listing of the names saved in `listFile`, one per line, that are relative to `path`. The
+// list file is read back for the names of a large listing, it must not change while it's open.
+// Files added with odroid_sdcard_dir_add go after the sorted ones and keep their names.
+odroid_sdcard_dir_t* odroid_sdcard_dir_load(const char* path, const char* listFile);
+void odroid_sdcard_dir_add(odroid_sdcard_dir_t* dir, const char* name);
+void odroid_sdcard_dir_close(odroid_sdcard_dir_t* dir);
+int odroid_sdcard_dir_count(odroid_sdcard_dir_t* dir);
+uint32_t odroid_sdcard_dir_hash(odroid_sdcard_dir_t* dir, int index);
+bool odroid_sdcard_dir_name(odroid_sdcard_dir_t* dir, int index, char* name, size_t size);
@@ -5336,6 +5336,26 @@ const UG_COLOR pal_checkbox_released[] =
 /* -------------------------------------------------------------------------------- */
 /* -- INTERNAL FUNCTIONS                                                         -- */
 /* -------------------------------------------------------------------------------- */
+/* Mixes fc over bc, alpha is 0 (bc) to 255 (fc) */
+static inline UG_COLOR _UG_Blend( UG_COLOR fc, UG_COLOR bc, UG_U8 alpha )
+{
+#ifdef USE_COLOR_RGB565
+   /* Spread the channels as 00000GGGGGG00000RRRRR000000BBBBB so that all three
+      are blended with a single multiply on a 5 bit alpha */
+   UG_U32 f = (fc | ((UG_U32)fc << 16)) & 0x07E0F81F;
+   UG_U32 b = (bc | ((UG_U32)bc << 16)) & 0x07E0F81F;
+   UG_U32 a = (alpha + 4) >> 3;
+
+   b += (f - b) * a >> 5;
+   b &= 0x07E0F81F;
+   return (UG_COLOR)((b >> 16) | b);
+#else
+   return ((((fc & 0x0000FF) * alpha + (bc & 0x0000FF) * (256 - alpha)) >> 8) & 0x0000FF) |//Blue component
+          ((((fc & 0x00FF00) * alpha + (bc & 0x00FF00) * (256 - alpha)) >> 8) & 0x00FF00) |//Green component
+          ((((fc & 0xFF0000) * alpha + (bc & 0xFF0000) * (256 - alpha)) >> 8) & 0xFF0000); //Red component
+#endif
+}
+
 void _UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font)
 {
    UG_U16 i,j,k,xo,yo,c,bn,actual_char_width;
@@ -5367,6 +5387,19 @@ void _UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const
    if ( font->char_width % 8 ) bn++;
    actual_char_width = (font->widths ? font->widths[bt - font->start_char] : font->char_width);
 
+   /* Can the driver expand whole rows of the glyph? */
+   if ( font->font_type == FONT_TYPE_1BPP && (gui->driver[DRIVER_DRAW_BITS].state & DRIVER_ENABLED) )
+   {
+      index = (bt - font->start_char)* font->char_height * bn;
+      for( j=0;j<font->char_height;j++ )
+      {
+         if( ((UG_RESULT(*)(UG_S16 x, UG_S16 y, UG_S16 w, const UG_U8* bits, UG_COLOR fc, UG_COLOR bc))gui->driver[DRIVER_DRAW_BITS].driver)(x,y+j,actual_char_width,&font->p[index],fc,bc) != UG_RESULT_OK ) break;
+         index += bn;
+      }
+      /* The driver refuses rows it can't draw (clipped), the glyph is then drawn below */
+      if ( j == font->char_height ) return;
+   }
+
    /* Is hardware acceleration available? */
    if ( gui->driver[DRIVER_FILL_AREA].state & DRIVER_ENABLED )
    {
@@ -5406,9 +5439,7 @@ void _UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const
 			  for( i=0;i<actual_char_width;i++ )
 			  {
 				 b = font->p[index++];
-				 color = ((((fc & 0x0000FF) * b + (bc & 0x0000FF) * (256 - b)) >> 8) & 0x0000FF) |//Blue component
-				         ((((fc & 0x00FF00) * b + (bc & 0x00FF00) * (256 - b)) >> 8) & 0x00FF00) |//Green component
-				         ((((fc & 0xFF0000) * b + (bc & 0xFF0000) * (256 - b)) >> 8) & 0xFF0000); //Red component
+				 color = _UG_Blend(fc, bc, b);
 				 push_pixel(color);
 			  }
 			  index += font->char_width - actual_char_width;
@@ -5455,9 +5486,7 @@ void _UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const
             for( i=0;i<actual_char_width;i++ )
             {
                b = font->p[index++];
-               color = ((((fc & 0x0000FF) * b + (bc & 0x0000FF) * (256 - b)) >> 8) & 0x0000FF) |//Blue component
-                       ((((fc & 0x00FF00) * b + (bc & 0x00FF00) * (256 - b)) >> 8) & 0x00FF00) |//Green component
-                       ((((fc & 0xFF0000) * b + (bc & 0xFF0000) * (256 - b)) >> 8) & 0xFF0000); //Red component
+               color = _UG_Blend(fc, bc, b);
                gui->pset(xo,yo,color);
                xo++;
             }
@@ -5887,10 +5916,8 @@ void UG_WaitForUpdate( void )
 
 void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp )
 {
-   UG_S16 x,y,xs;
-   UG_U8 r,g,b;
+   UG_S16 x,y;
    UG_U16* p;
-   UG_U16 tmp;
    UG_COLOR c;
 
    if ( bmp->p == NULL ) return;
@@ -5919,24 +5946,42 @@ void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp )
       return;
    }
 
-   xs = xp;
-   for(y=0;y<bmp->height;y++)
+   UG_BlitRGB565( xp, yp, bmp->width, bmp->height, p );
+}
+
+void UG_BlitRGB565( UG_S16 xp, UG_S16 yp, UG_S16 w, UG_S16 h, const UG_U16* p )
+{
+   UG_S16 x,y,stride;
+   UG_U16 tmp;
+   UG_COLOR c;
+
+   /* Clip to the screen, the source keeps its full stride */
+   stride = w;
+   if ( xp < 0 ) { p -= xp; w += xp; xp = 0; }
+   if ( yp < 0 ) { p -= yp * stride; h += yp; yp = 0; }
+   if ( xp + w > gui->x_dim ) w = gui->x_dim - xp;
+   if ( yp + h > gui->y_dim ) h = gui->y_dim - yp;
+   if ( w <= 0 || h <= 0 ) return;
+
+   /* Is hardware acceleration available? */
+   if ( gui->driver[DRIVER_BLIT_RGB565].state & DRIVER_ENABLED )
+   {
+      if( ((UG_RESULT(*)(UG_S16 x, UG_S16 y, UG_S16 w, UG_S16 h, const UG_U16* p, UG_S16 stride))gui->driver[DRIVER_BLIT_RGB565].driver)(xp,yp,w,h,p,stride) == UG_RESULT_OK ) return;
+   }
+
+   for(y=0;y<h;y++)
    {
-      xp = xs;
-      for(x=0;x<bmp->width;x++)
+      for(x=0;x<w;x++)
       {
-         tmp = *p++;
+         tmp = p[y*stride+x];
+         #ifdef USE_COLOR_RGB888
          /* Convert RGB565 to RGB888 */
-         r = (tmp>>11)&0x1F;
-         r<<=3;
-         g = (tmp>>5)&0x3F;
-         g<<=2;
-         b = (tmp)&0x1F;
-         b<<=3;
-         c = ((UG_COLOR)r<<16) | ((UG_COLOR)g<<8) | (UG_COLOR)b;
-         UG_DrawPixel( xp++ , yp , c );
+         c = ((UG_COLOR)(tmp>>11)<<19) | ((UG_COLOR)((tmp>>5)&0x3F)<<10) | ((UG_COLOR)(tmp&0x1F)<<3);
+         #else
+         c = tmp;
+         #endif
+         gui->pset( xp+x, yp+y, c );
       }
-      yp++;
    }
 }
 
@@ -548,10 +548,12 @@ typedef struct
 #define DRIVER_ENABLED                                (1<<1)
 
 /* Supported drivers */
-#define NUMBER_OF_DRIVERS                             3
+#define NUMBER_OF_DRIVERS                             5
 #define DRIVER_DRAW_LINE                              0
 #define DRIVER_FILL_FRAME                             1
 #define DRIVER_FILL_AREA                              2
+#define DRIVER_DRAW_BITS                              3  /* One row of a 1bpp glyph, LSB first */
+#define DRIVER_BLIT_RGB565                            4  /* Clipped rectangle of RGB565 pixels */
 
 /* -------------------------------------------------------------------------------- */
 /* -- µGUI CORE STRUCTURE                                                        -- */
@@ -916,6 +918,7 @@ void UG_FontSetVSpace( UG_U16 s );
 void UG_WaitForUpdate( void );
 void UG_Update( void );
 void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp );
+void UG_BlitRGB565( UG_S16 xp, UG_S16 yp, UG_S16 w, UG_S16 h, const UG_U16* p );
 void UG_TouchUpdate( UG_S16 xp, UG_S16 yp, UG_U8 state );
 
 /* Driver functions */